@@ -0,0 +1,423 @@
+#include "bench/baseline.hpp"
+#include "bench/harness.hpp"
+#include "matrix/matrix.hpp"
+#include "matrix/covariance.hpp"
+#include "matrix/distance.hpp"
+#include "matrix/transpose.hpp"
+#include "matrix/triangular.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+
+using namespace matrix;
+
+namespace
+{
+
+    // Options: Command line of the benchmark binary.
+    struct Options
+    {
+        bool counters{true};
+        std::string filter; // Run only operations whose name contains this.
+        size_t repetitions{bench::default_repetitions};
+        std::string json;     // Write the results to this file.
+        std::string baseline; // Compare the results with this file and fail on regressions.
+        double tolerance{0.05};
+        std::vector<bench::Tolerance> tolerances; // Per-benchmark overrides of the tolerance.
+    };
+
+    // Exit statuses: a regression against the baseline, or a bad command line or file.
+    constexpr int exit_regression = 1;
+    constexpr int exit_usage = 2;
+
+    [[noreturn]] void usage(const char *program, int const status)
+    {
+        (status == 0 ? std::cout : std::cerr)
+            << "Usage: " << program << " [options] [operation]\n"
+            << "  --no-counters          time only, without perf_event_open counters\n"
+            << "  --repetitions N        timed samples per benchmark (default " << bench::default_repetitions << ")\n"
+            << "  --json FILE            write the results to FILE\n"
+            << "  --baseline FILE        compare with the results in FILE; exit with " << exit_regression << " on a regression\n"
+            << "  --tolerance [OP=]PCT   accepted slowdown in percent (default 5), for benchmarks containing OP if given\n";
+        std::exit(status);
+    }
+
+    double percent(const char *program, const std::string &text)
+    {
+        try
+        {
+            size_t end{0};
+            double const value = std::stod(text, &end);
+            if (end == text.size() && value >= 0)
+            {
+                return value / 100;
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        usage(program, exit_usage);
+    }
+
+    Options parse(int argc, char **argv)
+    {
+        Options options;
+        auto value = [&](int &i)
+        {
+            if (i + 1 >= argc)
+            {
+                usage(argv[0], exit_usage);
+            }
+            return std::string(argv[++i]);
+        };
+        for (int i{1}; i < argc; i++)
+        {
+            if (std::strcmp(argv[i], "--no-counters") == 0)
+            {
+                options.counters = false;
+            }
+            else if (std::strcmp(argv[i], "--repetitions") == 0)
+            {
+                std::string const n = value(i);
+                options.repetitions = size_t(std::strtoul(n.c_str(), nullptr, 10));
+                if (options.repetitions < 2)
+                {
+                    usage(argv[0], exit_usage); // A confidence interval needs at least two samples.
+                }
+            }
+            else if (std::strcmp(argv[i], "--json") == 0)
+            {
+                options.json = value(i);
+            }
+            else if (std::strcmp(argv[i], "--baseline") == 0)
+            {
+                options.baseline = value(i);
+            }
+            else if (std::strcmp(argv[i], "--tolerance") == 0)
+            {
+                std::string const rule = value(i);
+                size_t const eq = rule.rfind('=');
+                if (eq == std::string::npos)
+                {
+                    options.tolerance = percent(argv[0], rule);
+                }
+                else
+                {
+                    options.tolerances.push_back({rule.substr(0, eq), percent(argv[0], rule.substr(eq + 1))});
+                }
+            }
+            else if (std::strcmp(argv[i], "--help") == 0)
+            {
+                usage(argv[0], 0);
+            }
+            else
+            {
+                options.filter = argv[i];
+            }
+        }
+        return options;
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    std::unique_ptr<SimpleMatrix<T, ROW, COL>> sample()
+    {
+        auto m = std::make_unique<SimpleMatrix<T, ROW, COL>>();
+        std::iota(m->begin(), m->end(), T{1});
+        return m;
+    }
+
+    // Benchmark: One named operation on matrices of a fixed shape.
+    struct Benchmark
+    {
+        std::string name;
+        bench::Result (*run)(bench::PerfCounters &, size_t repetitions);
+    };
+
+    template <class T, size_t M, size_t K, size_t N>
+    bench::Result multiply(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, M, K>();
+        auto b = sample<T, K, N>();
+        return bench::measure("multiply/" + std::to_string(M) + "x" + std::to_string(K) + "x" + std::to_string(N), double(M * N),
+                              2.0 * M * K * N, counters, [&]
+                              { bench::do_not_optimize(*a * *b); }, repetitions);
+    }
+
+    // Matrix-vector products through operator*: A * x, or x^T * A when TRANSPOSED.
+    template <class T, size_t ROW, size_t COL, bool TRANSPOSED>
+    bench::Result matrix_vector(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        std::string const shape = std::to_string(ROW) + "x" + std::to_string(COL);
+        if constexpr (TRANSPOSED)
+        {
+            auto x = sample<T, 1, ROW>();
+            return bench::measure("gemv/" + shape + "/transposed", double(COL), 2.0 * ROW * COL, counters, [&]
+                                  { bench::do_not_optimize(*x * *a); }, repetitions);
+        }
+        else
+        {
+            auto x = sample<T, COL, 1>();
+            return bench::measure("gemv/" + shape, double(ROW), 2.0 * ROW * COL, counters, [&]
+                                  { bench::do_not_optimize(*a * *x); }, repetitions);
+        }
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result outer(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto x = sample<T, ROW, 1>();
+        auto y = sample<T, 1, COL>();
+        return bench::measure("outer/" + std::to_string(ROW) + "x" + std::to_string(COL), double(ROW * COL), double(ROW * COL), counters, [&]
+                              { bench::do_not_optimize(*x * *y); }, repetitions);
+    }
+
+    // Covariance of N samples of dimension D in one streaming pass.
+    template <class T, size_t N, size_t D>
+    bench::Result covariances(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, N, D>();
+        return bench::measure("covariance/" + std::to_string(N) + "x" + std::to_string(D), double(N * D), 3.0 * N * D * (D + 1) / 2, counters, [&]
+                              { bench::do_not_optimize(covariance(*a)); }, repetitions);
+    }
+
+    // Squared distances between N and M random points of dimension D, all of them or only the K nearest.
+    template <class T, size_t N, size_t M, size_t D, size_t K = 0>
+    bench::Result distances(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<T> dist(-1, 1);
+        auto a = std::make_unique<SimpleMatrix<T, N, D>>();
+        auto b = std::make_unique<SimpleMatrix<T, M, D>>();
+        std::generate(a->begin(), a->end(), [&]
+                      { return dist(gen); });
+        std::generate(b->begin(), b->end(), [&]
+                      { return dist(gen); });
+        std::string const shape = std::to_string(N) + "x" + std::to_string(M) + "x" + std::to_string(D);
+        if constexpr (K == 0)
+        {
+            return bench::measure("distances/" + shape, double(N * M), 3.0 * N * M * D, counters, [&]
+                                  { bench::do_not_optimize(pairwise_squared_distances(*a, *b)); }, repetitions);
+        }
+        else
+        {
+            return bench::measure("nearest/" + shape + "/k" + std::to_string(K), double(N * M), 3.0 * N * M * D, counters, [&]
+                                  { bench::do_not_optimize(nearest_neighbors<K>(*a, *b)); }, repetitions);
+        }
+    }
+
+    // Lower triangular solve of K right-hand sides (TRSM; TRSV when K is 1).
+    template <class T, size_t N, size_t K>
+    bench::Result triangular(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto dense = std::make_unique<SimpleMatrix<T, N, N>>();
+        std::fill(dense->begin(), dense->end(), T{1} / T(N));
+        for (size_t i{0}; i < N; i++)
+        {
+            dense->row(i)[i] = T{1};
+        }
+        TriangularMatrix<T, N> const a(*dense);
+        auto b = sample<T, N, K>();
+        return bench::measure("triangular_solve/" + std::to_string(N) + "x" + std::to_string(K), double(N * K), double(N * N * K), counters, [&]
+                              { bench::do_not_optimize(triangular_solve(a, *b)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL, size_t NEW_ROW, size_t NEW_COL>
+    bench::Result resize(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        return bench::measure("resize/" + std::to_string(ROW) + "x" + std::to_string(COL) + "->" + std::to_string(NEW_ROW) + "x" + std::to_string(NEW_COL),
+                              double(NEW_ROW * NEW_COL), 0, counters, [&]
+                              { bench::do_not_optimize(matrix::resize<NEW_ROW, NEW_COL>(*a)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL1, size_t COL2>
+    bench::Result concat(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL1>();
+        auto b = sample<T, ROW, COL2>();
+        return bench::measure("concat/" + std::to_string(ROW) + "x(" + std::to_string(COL1) + "|" + std::to_string(COL2) + ")",
+                              double(ROW * (COL1 + COL2)), 0, counters, [&]
+                              { bench::do_not_optimize(*a | *b); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result concat_chain(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        return bench::measure("concat/" + std::to_string(ROW) + "x(" + std::to_string(COL) + "|x4 chained)",
+                              double(ROW * 4 * COL), 0, counters, [&]
+                              { bench::do_not_optimize(*a | *a | *a | *a); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result hconcat4(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        return bench::measure("hconcat/" + std::to_string(ROW) + "x(" + std::to_string(COL) + "x4)",
+                              double(ROW * 4 * COL), 0, counters, [&]
+                              { bench::do_not_optimize(hconcat(*a, *a, *a, *a)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result transposed(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        return bench::measure("transpose/" + std::to_string(ROW) + "x" + std::to_string(COL), double(ROW * COL), 0, counters, [&]
+                              { bench::do_not_optimize(transpose(*a)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL, Summation HOW>
+    bench::Result summed(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        const char *how = HOW == Summation::Kahan ? "kahan" : HOW == Summation::Pairwise ? "pairwise" : "plain";
+        return bench::measure("sum/" + std::to_string(ROW) + "x" + std::to_string(COL) + "/" + how, double(ROW * COL), double(ROW * COL), counters, [&]
+                              { bench::do_not_optimize(sum(*a, HOW)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result column_sums(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        return bench::measure("col_sums/" + std::to_string(ROW) + "x" + std::to_string(COL), double(ROW * COL), double(ROW * COL), counters, [&]
+                              { bench::do_not_optimize(col_sums(*a)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result maximum(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        return bench::measure("argmax/" + std::to_string(ROW) + "x" + std::to_string(COL), double(ROW * COL), 0, counters, [&]
+                              { bench::do_not_optimize(argmax(*a)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL, class Policy>
+    bench::Result mapped(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        const char *policy = Policy::vectorize ? (Policy::parallel ? "par_unseq" : "unseq") : (Policy::parallel ? "par" : "seq");
+        auto clamp = [](T x)
+        { return x < T{100} ? T{100} : x > T{1000} ? T{1000} : x; };
+        return bench::measure("map/" + std::to_string(ROW) + "x" + std::to_string(COL) + "/" + policy, double(ROW * COL), 0, counters, [&]
+                              { bench::do_not_optimize(map(Policy{}, *a, clamp)); }, repetitions);
+    }
+
+    template <class T, size_t ROW, size_t COL>
+    bench::Result centered(bench::PerfCounters &counters, size_t const repetitions)
+    {
+        auto a = sample<T, ROW, COL>();
+        auto const means = col_means(*a);
+        return bench::measure("broadcast/" + std::to_string(ROW) + "x" + std::to_string(COL) + "-row", double(ROW * COL), double(ROW * COL), counters, [&]
+                              { bench::do_not_optimize(zip_with_inplace(*a, means, std::minus<>{})); }, repetitions);
+    }
+
+    const std::vector<Benchmark> benchmarks{
+        {"multiply", multiply<float, 64, 64, 64>},
+        {"multiply", multiply<float, 256, 256, 256>},
+        {"multiply", multiply<double, 512, 512, 512>},
+        {"multiply", multiply<float, 1024, 64, 1024>},
+        {"gemv", matrix_vector<float, 2048, 2048, false>},
+        {"gemv", matrix_vector<float, 2048, 2048, true>},
+        {"gemv", matrix_vector<double, 64, 64, false>},
+        {"outer", outer<float, 2048, 2048>},
+        {"covariance", covariances<float, 1048576, 3>},
+        {"covariance", covariances<float, 262144, 6>},
+        {"distances", distances<float, 1024, 4096, 3>},
+        {"nearest", distances<float, 4096, 8192, 3, 1>},
+        {"nearest", distances<float, 4096, 8192, 3, 8>},
+        {"triangular_solve", triangular<double, 2048, 1>},
+        {"triangular_solve", triangular<double, 1024, 64>},
+        {"resize", resize<float, 1024, 1024, 1024, 1536>},
+        {"resize", resize<float, 1024, 1024, 512, 512>},
+        {"concat", concat<float, 1024, 512, 512>},
+        {"concat", concat<double, 64, 3, 5>},
+        {"concat", concat_chain<float, 1024, 256>},
+        {"concat", hconcat4<float, 1024, 256>},
+        {"transpose", transposed<float, 1024, 1024>},
+        {"transpose", transposed<double, 1000, 700>},
+        {"sum", summed<float, 1024, 1024, Summation::Plain>},
+        {"sum", summed<float, 1024, 1024, Summation::Kahan>},
+        {"sum", summed<float, 1024, 1024, Summation::Pairwise>},
+        {"col_sums", column_sums<float, 1024, 1024>},
+        {"argmax", maximum<float, 1024, 1024>},
+        {"map", mapped<float, 1024, 1024, execution::sequenced_policy>},
+        {"map", mapped<float, 1024, 1024, execution::parallel_unsequenced_policy>},
+        {"broadcast", centered<float, 1024, 1024>},
+    };
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options const options = parse(argc, argv);
+
+    // Read the baseline first, so a missing or malformed file fails before the suite runs.
+    std::vector<bench::Result> baseline;
+    if (!options.baseline.empty())
+    {
+        std::ifstream in(options.baseline);
+        try
+        {
+            if (!in)
+            {
+                throw std::runtime_error("Cannot open " + options.baseline);
+            }
+            baseline = bench::read_json(in);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return exit_usage;
+        }
+    }
+
+    // Opened before any kernel starts the thread pool, so the workers inherit the counters.
+    bench::PerfCounters counters(options.counters);
+    if (options.counters && !counters.hardware())
+    {
+        std::cout << "Hardware performance counters are unavailable; reporting time and software events only.\n";
+    }
+
+    std::vector<bench::Result> results;
+    for (auto const &b : benchmarks)
+    {
+        if (b.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+        results.push_back(b.run(counters, options.repetitions));
+        bench::report(std::cout, results.back());
+    }
+
+    if (!options.json.empty())
+    {
+        std::ofstream out(options.json);
+        bench::write_json(out, results);
+        if (!out)
+        {
+            std::cerr << "Cannot write " << options.json << "\n";
+            return exit_usage;
+        }
+    }
+
+    if (!options.baseline.empty())
+    {
+        auto const comparisons = bench::compare(baseline, results, options.tolerances, options.tolerance);
+        std::cout << "\nComparison with " << options.baseline << " (95% confidence intervals):\n";
+        bench::report(std::cout, comparisons);
+        for (auto const &c : comparisons)
+        {
+            if (c.verdict == bench::Verdict::Slower)
+            {
+                return exit_regression;
+            }
+        }
+    }
+    return 0;
+}
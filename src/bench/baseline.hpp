@@ -0,0 +1,345 @@
+#pragma once
+
+#include <cctype>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "harness.hpp"
+#include "statistics.hpp"
+
+namespace bench
+{
+
+    namespace detail
+    {
+
+        // Quote a string for JSON, escaping the characters JsonReader::string unescapes.
+        inline std::string json_string(const std::string &s)
+        {
+            std::string result{"\""};
+            for (char const c : s)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    result += '\\';
+                }
+                result += c == '\n' ? std::string("\\n") : c == '\t' ? std::string("\\t") : std::string(1, c);
+            }
+            return result + "\"";
+        }
+
+    } // namespace detail
+
+    // Write results as JSON: {"benchmarks": [{"name", "elements", "flops", "iterations", "seconds",
+    // "samples": [...], "events": {...}}, ...]}. Times are seconds per call.
+    inline void write_json(std::ostream &os, const std::vector<Result> &results)
+    {
+        auto const flags = os.flags();
+        auto const precision = os.precision();
+        os << std::setprecision(std::numeric_limits<double>::max_digits10) << "{\n  \"benchmarks\": [";
+        for (size_t i{0}; i < results.size(); i++)
+        {
+            auto const &r = results[i];
+            os << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << detail::json_string(r.name)
+               << ", \"elements\": " << r.elements << ", \"flops\": " << r.flops << ", \"iterations\": " << r.iterations << ", \"seconds\": " << r.seconds
+               << ",\n     \"samples\": [";
+            for (size_t s{0}; s < r.samples.size(); s++)
+            {
+                os << (s == 0 ? "" : ", ") << r.samples[s];
+            }
+            os << "],\n     \"events\": {";
+            for (size_t e{0}; e < r.events.size(); e++)
+            {
+                os << (e == 0 ? "" : ", ") << detail::json_string(r.events[e].name) << ": " << r.events[e].value;
+            }
+            os << "}}";
+        }
+        os << "\n  ]\n}\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    namespace detail
+    {
+
+        // JsonReader: Recursive-descent reader for the subset of JSON that write_json produces, which
+        // still accepts any valid document and skips members it does not know.
+        class JsonReader
+        {
+            std::istream &is_;
+
+            [[noreturn]] void fail(const std::string &what)
+            {
+                throw std::runtime_error("Invalid benchmark JSON: " + what);
+            }
+
+            char peek()
+            {
+                is_ >> std::ws;
+                return char(is_.peek());
+            }
+
+            void expect(char const c)
+            {
+                if (peek() != c)
+                {
+                    fail(std::string("expected '") + c + "'");
+                }
+                is_.get();
+            }
+
+            // Call f for each element of an array (or, with the key, each member of an object).
+            template <class F>
+            void elements(char const open, char const close, F &&f)
+            {
+                expect(open);
+                if (peek() == close)
+                {
+                    is_.get();
+                    return;
+                }
+                for (;;)
+                {
+                    f();
+                    char const c = peek();
+                    is_.get();
+                    if (c == close)
+                    {
+                        return;
+                    }
+                    if (c != ',')
+                    {
+                        fail(std::string("expected ',' or '") + close + "'");
+                    }
+                }
+            }
+
+        public:
+            explicit JsonReader(std::istream &is) : is_(is) {}
+
+            std::string string()
+            {
+                expect('"');
+                std::string result;
+                for (int c = is_.get(); c != '"'; c = is_.get())
+                {
+                    if (c == std::char_traits<char>::eof())
+                    {
+                        fail("unterminated string");
+                    }
+                    if (c == '\\')
+                    {
+                        c = is_.get();
+                        if (c == 'u')
+                        {
+                            fail("\\u escapes are not supported");
+                        }
+                        c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+                    }
+                    result += char(c);
+                }
+                return result;
+            }
+
+            double number()
+            {
+                peek();
+                double result;
+                if (!(is_ >> result))
+                {
+                    fail("expected a number");
+                }
+                return result;
+            }
+
+            template <class F>
+            void array(F &&f)
+            {
+                elements('[', ']', f);
+            }
+
+            // Call f(key) for each member; f reads the value.
+            template <class F>
+            void object(F &&f)
+            {
+                elements('{', '}', [&]
+                         {
+                             std::string const key = string();
+                             expect(':');
+                             f(key); });
+            }
+
+            void skip()
+            {
+                char const c = peek();
+                if (c == '{')
+                {
+                    object([&](const std::string &)
+                           { skip(); });
+                }
+                else if (c == '[')
+                {
+                    array([&]
+                          { skip(); });
+                }
+                else if (c == '"')
+                {
+                    string();
+                }
+                else if (std::isalpha(static_cast<unsigned char>(c)))
+                {
+                    while (std::isalpha(is_.peek()))
+                    {
+                        is_.get();
+                    }
+                }
+                else
+                {
+                    number();
+                }
+            }
+        };
+
+    } // namespace detail
+
+    // Read results written by write_json. Throws std::runtime_error when the input is malformed.
+    inline std::vector<Result> read_json(std::istream &is)
+    {
+        std::vector<Result> results;
+        detail::JsonReader json(is);
+        json.object([&](const std::string &key)
+                    {
+                        if (key != "benchmarks")
+                        {
+                            json.skip();
+                            return;
+                        }
+                        json.array([&]
+                                   {
+                                       Result r;
+                                       json.object([&](const std::string &field)
+                                                   {
+                                                       if (field == "name")
+                                                           r.name = json.string();
+                                                       else if (field == "elements")
+                                                           r.elements = json.number();
+                                                       else if (field == "flops")
+                                                           r.flops = json.number();
+                                                       else if (field == "iterations")
+                                                           r.iterations = size_t(json.number());
+                                                       else if (field == "seconds")
+                                                           r.seconds = json.number();
+                                                       else if (field == "samples")
+                                                           json.array([&]
+                                                                      { r.samples.push_back(json.number()); });
+                                                       else if (field == "events")
+                                                           json.object([&](const std::string &event)
+                                                                       { r.events.push_back({event, json.number()}); });
+                                                       else
+                                                           json.skip(); });
+                                       results.push_back(std::move(r)); }); });
+        return results;
+    }
+
+    // Tolerance: Slowdown accepted for benchmarks whose name contains `pattern` (all when empty),
+    // as a fraction of the baseline time.
+    struct Tolerance
+    {
+        std::string pattern;
+        double fraction;
+    };
+
+    // Tolerance for one benchmark: the last matching rule wins, so specific rules follow the default.
+    inline double tolerance_for(const std::string &name, const std::vector<Tolerance> &rules, double const fallback)
+    {
+        double result = fallback;
+        for (auto const &t : rules)
+        {
+            result = name.find(t.pattern) != std::string::npos ? t.fraction : result;
+        }
+        return result;
+    }
+
+    enum class Verdict
+    {
+        Unchanged,  // The difference is within the tolerance or not significant.
+        Faster,     // Significantly faster by more than the tolerance.
+        Slower,     // Significantly slower by more than the tolerance: a regression.
+        NoBaseline, // The baseline has no samples for this benchmark.
+    };
+
+    // Comparison: Relative change of one benchmark against its baseline, with the 95% confidence
+    // interval of that change.
+    struct Comparison
+    {
+        std::string name;
+        double baseline{0}; // Mean seconds per call.
+        double current{0};
+        Interval change{0, 0}; // (current - baseline) / baseline.
+        double tolerance{0};
+        Verdict verdict{Verdict::NoBaseline};
+    };
+
+    // Compare every current result with the baseline entry of the same name. A benchmark regresses only
+    // when the whole confidence interval of its slowdown lies above the tolerance, so noise alone does
+    // not fail the gate however small the tolerance.
+    inline std::vector<Comparison> compare(const std::vector<Result> &baseline, const std::vector<Result> &current,
+                                           const std::vector<Tolerance> &rules, double const default_tolerance)
+    {
+        std::map<std::string, const Result *> by_name;
+        for (auto const &b : baseline)
+        {
+            by_name[b.name] = &b;
+        }
+
+        std::vector<Comparison> result;
+        for (auto const &c : current)
+        {
+            Comparison cmp{c.name, 0, c.seconds, {0, 0}, tolerance_for(c.name, rules, default_tolerance), Verdict::NoBaseline};
+            auto const it = by_name.find(c.name);
+            if (it != by_name.end() && !it->second->samples.empty() && it->second->seconds > 0)
+            {
+                auto const &b = *it->second;
+                Interval const diff = welch95(b.samples, c.samples);
+                cmp.baseline = b.seconds;
+                cmp.change = {diff.estimate / b.seconds, diff.half_width / b.seconds};
+                cmp.verdict = cmp.change.lower() > cmp.tolerance    ? Verdict::Slower
+                              : cmp.change.upper() < -cmp.tolerance ? Verdict::Faster
+                                                                    : Verdict::Unchanged;
+            }
+            result.push_back(cmp);
+        }
+        return result;
+    }
+
+    // Print one line per comparison: baseline and current time, the change with its confidence interval,
+    // and the verdict.
+    inline void report(std::ostream &os, const std::vector<Comparison> &comparisons)
+    {
+        auto const flags = os.flags();
+        auto const precision = os.precision();
+        for (auto const &c : comparisons)
+        {
+            os << std::left << std::setw(34) << c.name << std::right << std::fixed << std::setprecision(3);
+            if (c.verdict == Verdict::NoBaseline)
+            {
+                os << std::setw(12) << "-" << " -> " << std::setw(12) << c.current * 1e6 << " us    no baseline\n";
+                continue;
+            }
+            os << std::setw(12) << c.baseline * 1e6 << " -> " << std::setw(12) << c.current * 1e6 << " us"
+               << std::showpos << std::setprecision(1) << std::setw(9) << c.change.estimate * 100 << "%"
+               << std::noshowpos << " +- " << std::setw(5) << c.change.half_width * 100 << "%"
+               << "  (tolerance " << c.tolerance * 100 << "%)  "
+               << (c.verdict == Verdict::Slower ? "REGRESSION" : c.verdict == Verdict::Faster ? "faster" : "ok") << "\n";
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+} // namespace bench
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "perf_counters.hpp"
+#include "statistics.hpp"
+
+namespace bench
+{
+
+    // Minimum wall time of one timed batch; short operations are repeated until they reach it.
+    inline constexpr double min_batch_seconds = 0.05;
+
+    // Timed batches per benchmark when none is requested; each batch is one sample of the time per call.
+    inline constexpr size_t default_repetitions = 10;
+
+    // Result: Time and event counts of one benchmark, per call of the operation.
+    struct Result
+    {
+        std::string name;
+        double elements{0}; // Elements of the result (the size used for per-element ratios).
+        double flops{0};    // Arithmetic operations of one call, 0 for pure data movement.
+        size_t iterations{0};          // Calls per sample.
+        double seconds{0};             // Mean time per call over the samples.
+        std::vector<double> samples{}; // Time per call of each timed batch.
+        std::vector<PerfCounters::Reading> events;
+    };
+
+    // Keep the compiler from discarding a value that is otherwise unused.
+    template <class T>
+    void do_not_optimize(T const &value)
+    {
+        asm volatile(""
+                     :
+                     : "r,m"(value)
+                     : "memory");
+    }
+
+    // Run f once to warm up, find an iteration count that fills min_batch_seconds, then time `repetitions`
+    // batches of that many calls with the counters running. The reported figures are per call.
+    template <class F>
+    Result measure(std::string name, double const elements, double const flops, PerfCounters &counters, F &&f,
+                   size_t const repetitions = default_repetitions)
+    {
+        using clock = std::chrono::steady_clock;
+        auto run = [&](size_t n)
+        {
+            auto const start = clock::now();
+            for (size_t i{0}; i < n; i++)
+            {
+                f();
+            }
+            return std::chrono::duration<double>(clock::now() - start).count();
+        };
+
+        run(1);
+        size_t iterations{1};
+        for (double t = run(1); t < min_batch_seconds && iterations < (size_t{1} << 30);)
+        {
+            iterations = size_t(double(iterations) * std::clamp(min_batch_seconds / std::max(t, 1e-9) * 1.2, 2.0, 100.0));
+            t = run(iterations);
+        }
+
+        Result result{std::move(name), elements, flops, iterations, 0, {}, {}};
+        counters.start();
+        for (size_t i{0}; i < std::max<size_t>(repetitions, 1); i++)
+        {
+            result.samples.push_back(run(iterations) / double(iterations));
+        }
+        counters.stop();
+        result.seconds = mean(result.samples);
+
+        double const calls = double(iterations * result.samples.size());
+        for (auto const &r : counters.readings())
+        {
+            result.events.push_back({r.name, r.value / calls});
+        }
+        return result;
+    }
+
+    // Print one result: mean time with its 95% confidence interval and throughput, then every event per call, per element and per flop,
+    // plus instructions per cycle when both are counted.
+    inline void report(std::ostream &os, const Result &r)
+    {
+        auto const flags = os.flags();
+        auto const precision = os.precision();
+
+        os << std::left << std::setw(34) << r.name << std::right << std::fixed << std::setprecision(3)
+           << std::setw(12) << r.seconds * 1e6 << " us +- " << std::setw(4) << std::setprecision(1)
+           << confidence95(r.samples) / r.seconds * 100 << "%" << std::setprecision(3);
+        if (r.flops > 0)
+        {
+            os << std::setw(10) << r.flops / r.seconds * 1e-9 << " GFLOP/s";
+        }
+        os << std::setw(10) << r.elements / r.seconds * 1e-9 << " Gelem/s\n";
+
+        double cycles{0};
+        double instructions{0};
+        for (auto const &e : r.events)
+        {
+            os << "    " << std::left << std::setw(16) << e.name << std::right << std::setprecision(0)
+               << std::setw(16) << e.value << std::setprecision(4) << std::setw(12) << e.value / r.elements << " /elem";
+            if (r.flops > 0)
+            {
+                os << std::setw(12) << e.value / r.flops << " /flop";
+            }
+            os << "\n";
+            cycles = e.name == "cycles" ? e.value : cycles;
+            instructions = e.name == "instructions" ? e.value : instructions;
+        }
+        if (cycles > 0 && instructions > 0)
+        {
+            os << "    " << std::left << std::setw(16) << "ipc" << std::right << std::setprecision(3)
+               << std::setw(16) << instructions / cycles << "\n";
+        }
+
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+} // namespace bench
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+
+    // PerfCounters: Hardware and software event counters of the calling thread, and of the threads it
+    // starts after construction, read through perf_event_open. Every event is opened on its own, so an event
+    // the kernel or PMU refuses is simply left out; on systems without perf_event_open nothing is
+    // available and start()/stop() do nothing.
+    class PerfCounters
+    {
+    public:
+        // Value of one event over the last start()/stop() interval, scaled for multiplexing.
+        struct Reading
+        {
+            std::string name;
+            double value;
+        };
+
+    private:
+        struct Event
+        {
+            std::string name;
+            int fd;
+        };
+
+        std::vector<Event> events_;
+        std::vector<Reading> readings_;
+        bool hardware_{false};
+
+#if defined(__linux__)
+        static bool intel()
+        {
+            std::ifstream cpuinfo("/proc/cpuinfo");
+            std::string line;
+            while (std::getline(cpuinfo, line))
+            {
+                if (line.rfind("vendor_id", 0) == 0)
+                {
+                    return line.find("GenuineIntel") != std::string::npos;
+                }
+            }
+            return false;
+        }
+
+        void open(const char *name, uint32_t const type, uint64_t const config)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1; // Count worker threads created after the counters are opened.
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int const fd = int(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd >= 0)
+            {
+                events_.push_back({name, fd});
+                hardware_ = hardware_ || type != PERF_TYPE_SOFTWARE;
+            }
+        }
+#endif
+
+    public:
+        // Constructor: Open every event the system allows; pass false to measure time only.
+        explicit PerfCounters(bool const enable = true)
+        {
+#if defined(__linux__)
+            if (!enable)
+            {
+                return;
+            }
+            constexpr auto cache = [](uint64_t id, uint64_t op, uint64_t result)
+            { return id | (op << 8) | (result << 16); };
+
+            open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            open("l1d_misses", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+            open("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+            if (intel())
+            {
+                // FP_ARITH_INST_RETIRED with every packed (128/256/512-bit) umask: vector arithmetic instructions.
+                open("vector_ops", PERF_TYPE_RAW, 0xc7 | (0xfcull << 8));
+            }
+            open("page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#else
+            (void)enable;
+#endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        ~PerfCounters()
+        {
+#if defined(__linux__)
+            for (auto const &e : events_)
+            {
+                ::close(e.fd);
+            }
+#endif
+        }
+
+        // True when at least one hardware event could be opened.
+        bool hardware() const
+        {
+            return hardware_;
+        }
+
+        // Names of the events that are counted.
+        std::vector<std::string> names() const
+        {
+            std::vector<std::string> result;
+            for (auto const &e : events_)
+            {
+                result.push_back(e.name);
+            }
+            return result;
+        }
+
+        void start()
+        {
+#if defined(__linux__)
+            for (auto const &e : events_)
+            {
+                ::ioctl(e.fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        void stop()
+        {
+            readings_.clear();
+#if defined(__linux__)
+            for (auto const &e : events_)
+            {
+                ::ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+            for (auto const &e : events_)
+            {
+                uint64_t data[3]{}; // value, time enabled, time running
+                if (::read(e.fd, data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0)
+                {
+                    continue;
+                }
+                readings_.push_back({e.name, double(data[0]) * double(data[1]) / double(data[2])});
+            }
+#endif
+        }
+
+        // Event values of the last start()/stop() interval.
+        const std::vector<Reading> &readings() const
+        {
+            return readings_;
+        }
+    }; // PerfCounters
+
+} // namespace bench
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace bench
+{
+
+    inline double mean(const std::vector<double> &samples)
+    {
+        return samples.empty() ? 0.0 : std::accumulate(samples.begin(), samples.end(), 0.0) / double(samples.size());
+    }
+
+    // Unbiased sample variance.
+    inline double variance(const std::vector<double> &samples)
+    {
+        if (samples.size() < 2)
+        {
+            return 0.0;
+        }
+        double const m = mean(samples);
+        double sum{0};
+        for (double s : samples)
+        {
+            sum += (s - m) * (s - m);
+        }
+        return sum / double(samples.size() - 1);
+    }
+
+    // Two-sided 95% quantile of Student's t distribution with `df` degrees of freedom, from the
+    // Cornish-Fisher expansion around the normal quantile; within 1% of the exact value for df >= 3.
+    inline double student_t95(double const df)
+    {
+        constexpr double z = 1.959963984540054;
+        if (df < 1)
+        {
+            return INFINITY;
+        }
+        double const z3 = z * z * z;
+        double const z5 = z3 * z * z;
+        double const z7 = z5 * z * z;
+        return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df) +
+               (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * df * df * df);
+    }
+
+    // Half width of the 95% confidence interval of the mean of `samples`.
+    inline double confidence95(const std::vector<double> &samples)
+    {
+        if (samples.size() < 2)
+        {
+            return INFINITY;
+        }
+        double const n = double(samples.size());
+        return student_t95(n - 1) * std::sqrt(variance(samples) / n);
+    }
+
+    // Interval: Estimate of a difference of means with the half width of its 95% confidence interval.
+    struct Interval
+    {
+        double estimate;
+        double half_width;
+
+        double lower() const
+        {
+            return estimate - half_width;
+        }
+
+        double upper() const
+        {
+            return estimate + half_width;
+        }
+    };
+
+    // Difference mean(b) - mean(a) by Welch's t-test, which does not assume equal variances.
+    inline Interval welch95(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        double const va = a.size() < 2 ? INFINITY : variance(a) / double(a.size());
+        double const vb = b.size() < 2 ? INFINITY : variance(b) / double(b.size());
+        double const estimate = mean(b) - mean(a);
+        double const v = va + vb;
+        if (!std::isfinite(v))
+        {
+            return {estimate, INFINITY};
+        }
+        if (v == 0)
+        {
+            return {estimate, 0.0};
+        }
+        double const df = v * v / (va * va / double(a.size() - 1) + vb * vb / double(b.size() - 1));
+        return {estimate, student_t95(df) * std::sqrt(v)};
+    }
+
+} // namespace bench
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "matrix.hpp"
+#include "kernels.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // BandedMatrix: A ROW x COL matrix whose non-zeros lie within KL diagonals below and KU diagonals
+    // above the main one. Each row stores its KL + KU + 1 band elements; slots of the band that fall
+    // outside the matrix are kept as zeros so that every row has the same layout.
+    template <typename T, size_t ROW, size_t COL, size_t KL, size_t KU>
+    class BandedMatrix
+    {
+        std::vector<T> data_;
+
+    public:
+        static constexpr size_t width = KL + KU + 1;
+
+        // Offset of element (r, c) in the band storage; (r, c) must lie in the band.
+        static constexpr size_t index(size_t const r, size_t const c)
+        {
+            return r * width + KL + c - r;
+        }
+
+        // Whether (r, c) lies in the band.
+        static constexpr bool in_band(size_t const r, size_t const c)
+        {
+            return c + KL >= r && c <= r + KU;
+        }
+
+        // Columns [lo, hi) of row r that lie in both the band and the matrix.
+        static constexpr std::pair<size_t, size_t> columns(size_t const r)
+        {
+            return {std::min(COL, r > KL ? r - KL : 0), std::min(COL, r + KU + 1)};
+        }
+
+        // Constructor: Initialize the matrix with default-initialized elements.
+        BandedMatrix() : data_(ROW * width) {}
+
+        // Constructor: Take the band of a dense matrix; elements outside it are ignored.
+        template <class S>
+        explicit BandedMatrix(const SimpleMatrix<T, ROW, COL, S> &m) : data_(ROW * width)
+        {
+            for (size_t i{0}; i < ROW; i++)
+            {
+                auto const [lo, hi] = columns(i);
+                std::copy(m.row(i) + lo, m.row(i) + hi, data_.data() + index(i, lo));
+            }
+        }
+
+        // Element at a specific row and column: zero outside the band.
+        constexpr T at(size_t const r, size_t const c) const
+        {
+            if (r >= ROW || c >= COL)
+            {
+                throw std::out_of_range("r >= ROW || c >= COL");
+            }
+            return in_band(r, c) ? data_[index(r, c)] : T{};
+        }
+
+        // Mutable reference to an element of the band; throws std::out_of_range for any other.
+        constexpr T &element(size_t const r, size_t const c)
+        {
+            if (r >= ROW || c >= COL)
+            {
+                throw std::out_of_range("r >= ROW || c >= COL");
+            }
+            if (!in_band(r, c))
+            {
+                throw std::out_of_range("Element is outside the band");
+            }
+            return data_[index(r, c)];
+        }
+
+        // Band of row r: its first element is column r - KL.
+        T *row(size_t const r)
+        {
+            return data_.data() + r * width;
+        }
+
+        const T *row(size_t const r) const
+        {
+            return data_.data() + r * width;
+        }
+
+        // Row r addressed by column: element c of the result is (r, c) for every column c in columns(r).
+        const T *row_by_column(size_t const r) const
+        {
+            return data_.data() + index(r, 0);
+        }
+
+        // Pointer to the band storage.
+        T *data()
+        {
+            return data_.data();
+        }
+
+        const T *data() const
+        {
+            return data_.data();
+        }
+
+        // Expand into a dense matrix with zeros outside the band.
+        SimpleMatrix<T, ROW, COL> dense() const
+        {
+            SimpleMatrix<T, ROW, COL> result;
+            for (size_t i{0}; i < ROW; i++)
+            {
+                auto const [lo, hi] = columns(i);
+                std::copy(row_by_column(i) + lo, row_by_column(i) + hi, result.row(i) + lo);
+            }
+            return result;
+        }
+
+        // Equality operator: compares the bands.
+        friend bool operator==(const BandedMatrix &lhs, const BandedMatrix &rhs)
+        {
+            return lhs.data_ == rhs.data_;
+        }
+
+        // Output operator to display the full matrix.
+        friend std::ostream &operator<<(std::ostream &os, const BandedMatrix &m)
+        {
+            return os << m.dense();
+        }
+    }; // BandedMatrix
+
+    namespace detail
+    {
+
+        // C = A * B for the banded A and the k-column B (row strides ldb and ldc; C starts zeroed). Rows
+        // of C run in parallel; each reads only the band of its row of A.
+        template <class T, size_t ROW, size_t COL, size_t KL, size_t KU>
+        void banded_multiply(const BandedMatrix<T, ROW, COL, KL, KU> &a, const T *b, size_t ldb, T *c, size_t ldc, size_t k)
+        {
+            using Band = BandedMatrix<T, ROW, COL, KL, KU>;
+            std::vector<T> buffer;
+            if (k == 1)
+            {
+                b = packed(b, ldb, COL, buffer);
+                ldb = 1;
+            }
+            size_t const grain = std::max<size_t>(1, parallel_threshold / (2 * Band::width * k));
+            parallel_for(0, ROW, grain, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t i{lo}; i < hi; i++)
+                             {
+                                 const T *ai = a.row_by_column(i);
+                                 auto const [j0, j1] = Band::columns(i);
+                                 T *ci = c + i * ldc;
+                                 if (k == 1)
+                                 {
+                                     ci[0] = dot(ai + j0, b + j0, j1 - j0);
+                                     continue;
+                                 }
+                                 for (size_t j{j0}; j < j1; j++)
+                                 {
+                                     axpy(ai[j], b + j * ldb, ci, k);
+                                 }
+                             } });
+        }
+
+        // Solve A * X = B by substitution for the triangular banded A over right-hand-side columns
+        // [c0, c1) of X (row stride ldx): forward when A is lower (KU == 0), backward when upper.
+        template <class T, size_t N, size_t KL, size_t KU>
+        void banded_solve(const BandedMatrix<T, N, N, KL, KU> &a, T *x, size_t ldx, size_t c0, size_t c1)
+        {
+            using Band = BandedMatrix<T, N, N, KL, KU>;
+            for (size_t step{0}; step < N; step++)
+            {
+                size_t const i = KU == 0 ? step : N - 1 - step;
+                const T *ai = a.row_by_column(i);
+                auto const [lo, hi] = Band::columns(i);
+                size_t const j0 = KU == 0 ? lo : i + 1;
+                size_t const j1 = KU == 0 ? i : hi;
+                T *xi = x + i * ldx;
+                if (c1 - c0 == 1)
+                {
+                    T sum{};
+                    for (size_t j{j0}; j < j1; j++)
+                    {
+                        sum += ai[j] * x[j * ldx + c0];
+                    }
+                    xi[c0] -= sum;
+                }
+                else
+                {
+                    for (size_t j{j0}; j < j1; j++)
+                    {
+                        axpy(-ai[j], x + j * ldx + c0, xi + c0, c1 - c0);
+                    }
+                }
+                T const inv = T{1} / ai[i];
+                for (size_t c{c0}; c < c1; c++)
+                {
+                    xi[c] *= inv;
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // Product of a banded matrix and a dense matrix in 2 * ROW * (KL + KU + 1) * K flops.
+    template <class T, size_t ROW, size_t COL, size_t KL, size_t KU, size_t K, class S>
+    SimpleMatrix<T, ROW, K, result_layout_t<S>> operator*(const BandedMatrix<T, ROW, COL, KL, KU> &a, const SimpleMatrix<T, COL, K, S> &b)
+    {
+        MATRIX_INSTRUMENT_SCOPE("banded_multiply", ROW, K, COL, 2 * ROW * a.width * K, (ROW * a.width + COL * K + ROW * K) * sizeof(T));
+        SimpleMatrix<T, ROW, K, result_layout_t<S>> result;
+        detail::banded_multiply(a, b.data(), b.stride(), result.data(), result.stride(), K);
+        return result;
+    }
+
+    // Solve A * X = B in place for a lower (KU == 0) or upper (KL == 0) triangular banded A.
+    // Right-hand-side columns are solved in parallel.
+    template <class T, size_t N, size_t KL, size_t KU, size_t K, class S>
+        requires(KL == 0 || KU == 0)
+    SimpleMatrix<T, N, K, S> &triangular_solve_inplace(const BandedMatrix<T, N, N, KL, KU> &a, SimpleMatrix<T, N, K, S> &b)
+    {
+        MATRIX_INSTRUMENT_SCOPE("banded_solve", N, K, N, 2 * N * a.width * K, (N * a.width + 2 * N * K) * sizeof(T));
+        T *const x = b.data(); // Once, before the threads start: this detaches shared storage.
+        size_t const grain = std::max<size_t>(1, parallel_threshold / (2 * N * a.width));
+        parallel_for(0, K, grain, [&](size_t c0, size_t c1)
+                     { detail::banded_solve(a, x, b.stride(), c0, c1); });
+        return b;
+    }
+
+    // Solve A * X = B for a lower (KU == 0) or upper (KL == 0) triangular banded A.
+    template <class T, size_t N, size_t KL, size_t KU, size_t K, class S>
+        requires(KL == 0 || KU == 0)
+    SimpleMatrix<T, N, K, result_layout_t<S>> triangular_solve(const BandedMatrix<T, N, N, KL, KU> &a, const SimpleMatrix<T, N, K, S> &b)
+    {
+        SimpleMatrix<T, N, K, result_layout_t<S>> x(b);
+        triangular_solve_inplace(a, x);
+        return x;
+    }
+
+    // Solve A * X = B in the storage of an expiring B.
+    template <class T, size_t N, size_t KL, size_t KU, size_t K, class S>
+        requires((KL == 0 || KU == 0) && std::is_same_v<result_layout_t<S>, S>)
+    SimpleMatrix<T, N, K, S> triangular_solve(const BandedMatrix<T, N, N, KL, KU> &a, SimpleMatrix<T, N, K, S> &&b)
+    {
+        triangular_solve_inplace(a, b);
+        return std::move(b);
+    }
+
+} // namespace matrix
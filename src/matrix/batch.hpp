@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include "matrix.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // Number of matrices interleaved in one block of a MatrixBatch: one aligned vector of T.
+    template <class T>
+    inline constexpr size_t batch_lanes = std::max<size_t>(1, default_alignment / sizeof(T));
+
+    // MatrixBatch: N matrices of the same shape stored interleaved, so element (r, c) of batch_lanes<T>
+    // consecutive matrices is one aligned vector. Kernels loop over that vector innermost and
+    // vectorize across the batch however small ROW and COL are.
+    template <typename T, size_t ROW, size_t COL>
+    class MatrixBatch
+    {
+    public:
+        static constexpr size_t lanes = batch_lanes<T>;
+
+        // Elements in one block of `lanes` matrices.
+        static constexpr size_t block_size = ROW * COL * lanes;
+
+    private:
+        size_t size_{0};
+        std::vector<T, AlignedAllocator<T>> data_;
+
+    public:
+        using value_type = T;
+
+        // Constructor: An empty batch.
+        MatrixBatch() = default;
+
+        // Constructor: n value-initialized matrices; the last block is padded with zero matrices.
+        explicit MatrixBatch(size_t const n) : size_(n), data_((n + lanes - 1) / lanes * block_size) {}
+
+        // Number of matrices in the batch.
+        size_t size() const
+        {
+            return size_;
+        }
+
+        // Number of interleaved blocks, including the partially filled last one.
+        size_t blocks() const
+        {
+            return data_.size() / block_size;
+        }
+
+        // Pointer to block k; element (r, c) of matrix k * lanes + l is at block(k)[(r * COL + c) * lanes + l].
+        T *block(size_t const k)
+        {
+            return data_.data() + k * block_size;
+        }
+
+        const T *block(size_t const k) const
+        {
+            return data_.data() + k * block_size;
+        }
+
+        // Access element (r, c) of matrix b.
+        T const &at(size_t const b, size_t const r, size_t const c) const
+        {
+            if (b >= size_ || r >= ROW || c >= COL)
+            {
+                throw std::out_of_range("b >= size() || r >= ROW || c >= COL");
+            }
+            return block(b / lanes)[(r * COL + c) * lanes + b % lanes];
+        }
+
+        T &at(size_t const b, size_t const r, size_t const c)
+        {
+            return const_cast<T &>(std::as_const(*this).at(b, r, c));
+        }
+
+        // Gather matrix b into a SimpleMatrix.
+        SimpleMatrix<T, ROW, COL> get(size_t const b) const
+        {
+            const T *src = &at(b, 0, 0);
+            SimpleMatrix<T, ROW, COL> result;
+            for (size_t i{0}; i < ROW; i++)
+            {
+                T *dst = result.row(i);
+                for (size_t j{0}; j < COL; j++)
+                {
+                    dst[j] = src[(i * COL + j) * lanes];
+                }
+            }
+            return result;
+        }
+
+        // Scatter a SimpleMatrix into slot b.
+        template <class S>
+        void set(size_t const b, const SimpleMatrix<T, ROW, COL, S> &m)
+        {
+            T *dst = &at(b, 0, 0);
+            for (size_t i{0}; i < ROW; i++)
+            {
+                const T *src = m.row(i);
+                for (size_t j{0}; j < COL; j++)
+                {
+                    dst[(i * COL + j) * lanes] = src[j];
+                }
+            }
+        }
+    }; // MatrixBatch
+
+    namespace detail
+    {
+
+        // Arithmetic type of the batched kernels: compact floats compute in float.
+        template <class T>
+        using batch_compute_t = std::conditional_t<is_compact_float_v<T>, accumulator_t<T>, T>;
+
+        // Run f(lo, hi) over chunks of the blocks of a batch, in parallel; f may set up per-chunk scratch.
+        template <class F>
+        void for_each_block_range(size_t const blocks, size_t const block_work, F &&f)
+        {
+            size_t const grain = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, block_work));
+            parallel_for(0, blocks, grain, f);
+        }
+
+        // Run f(block) over every block of a batch, threading across chunks of blocks.
+        template <class F>
+        void for_each_block(size_t const blocks, size_t const block_work, F &&f)
+        {
+            for_each_block_range(blocks, block_work, [&](size_t lo, size_t hi)
+                                 {
+                                     for (size_t k{lo}; k < hi; k++)
+                                     {
+                                         f(k);
+                                     } });
+        }
+
+    } // namespace detail
+
+    // Multiply every pair of matrices: result[i] = a[i] * b[i].
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2>
+    MatrixBatch<T, ROW1, COL2> batched_multiply(const MatrixBatch<T, ROW1, COL1> &a, const MatrixBatch<T, ROW2, COL2> &b)
+    {
+        static_assert(COL1 == ROW2, "Matrix dimensions are incompatible for multiplication.");
+        if (a.size() != b.size())
+        {
+            throw std::invalid_argument("Batch sizes differ");
+        }
+
+        MATRIX_INSTRUMENT_SCOPE("batched_multiply", ROW1, COL2, COL1, 2 * ROW1 * COL1 * COL2 * a.size(),
+                                (ROW1 * COL1 + COL1 * COL2 + ROW1 * COL2) * sizeof(T) * a.size());
+
+        using Acc = detail::batch_compute_t<T>;
+        constexpr size_t W = batch_lanes<T>;
+
+        MatrixBatch<T, ROW1, COL2> result(a.size());
+        detail::for_each_block(a.blocks(), ROW1 * COL1 * COL2 * W, [&](size_t k)
+                               {
+                                   const T *pa = std::assume_aligned<default_alignment>(a.block(k));
+                                   const T *pb = std::assume_aligned<default_alignment>(b.block(k));
+                                   T *pc = std::assume_aligned<default_alignment>(result.block(k));
+                                   for (size_t i{0}; i < ROW1; i++)
+                                   {
+                                       for (size_t j{0}; j < COL2; j++)
+                                       {
+                                           Acc acc[W]{};
+                                           for (size_t kk{0}; kk < COL1; kk++)
+                                           {
+                                               const T *x = pa + (i * COL1 + kk) * W;
+                                               const T *y = pb + (kk * COL2 + j) * W;
+                                               for (size_t l{0}; l < W; l++)
+                                               {
+                                                   acc[l] += Acc(x[l]) * Acc(y[l]);
+                                               }
+                                           }
+                                           T *z = pc + (i * COL2 + j) * W;
+                                           for (size_t l{0}; l < W; l++)
+                                           {
+                                               z[l] = T(acc[l]);
+                                           }
+                                       }
+                                   } });
+        return result;
+    }
+
+    // Add every pair of matrices: result[i] = a[i] + b[i].
+    template <class T, size_t ROW, size_t COL>
+    MatrixBatch<T, ROW, COL> batched_add(MatrixBatch<T, ROW, COL> a, const MatrixBatch<T, ROW, COL> &b)
+    {
+        if (a.size() != b.size())
+        {
+            throw std::invalid_argument("Batch sizes differ");
+        }
+
+        MATRIX_INSTRUMENT_SCOPE("batched_add", ROW, COL, 0, ROW * COL * a.size(), 3 * ROW * COL * sizeof(T) * a.size());
+
+        using Acc = detail::batch_compute_t<T>;
+        constexpr size_t n = MatrixBatch<T, ROW, COL>::block_size;
+
+        detail::for_each_block(a.blocks(), n, [&](size_t k)
+                               {
+                                   T *x = std::assume_aligned<default_alignment>(a.block(k));
+                                   const T *y = std::assume_aligned<default_alignment>(b.block(k));
+                                   for (size_t e{0}; e < n; e++)
+                                   {
+                                       x[e] = T(Acc(x[e]) + Acc(y[e]));
+                                   } });
+        return a;
+    }
+
+    // Invert every matrix by Gauss-Jordan elimination with partial pivoting. Pivot search and row swaps
+    // are per matrix; the elimination itself runs across the whole block of matrices. Throws
+    // std::domain_error naming a singular matrix.
+    template <class T, size_t N>
+    MatrixBatch<T, N, N> batched_inverse(const MatrixBatch<T, N, N> &a)
+    {
+        using Acc = detail::batch_compute_t<T>;
+        static_assert(std::is_floating_point_v<Acc>, "Batched inverse requires a floating-point element type.");
+        MATRIX_INSTRUMENT_SCOPE("batched_inverse", N, N, 0, 2 * N * N * N * a.size(), 2 * N * N * sizeof(T) * a.size());
+        constexpr size_t W = batch_lanes<T>;
+
+        MatrixBatch<T, N, N> result(a.size());
+        detail::for_each_block_range(a.blocks(), N * N * N * W, [&](size_t lo, size_t hi)
+                               {
+                                   // Scratch is shared by every block of the chunk.
+                                   std::vector<Acc> m(N * N * W);
+                                   std::vector<Acc> inv(N * N * W);
+                                   for (size_t k{lo}; k < hi; k++)
+                                   {
+                                       const T *src = a.block(k);
+                                       for (size_t e{0}; e < N * N * W; e++)
+                                       {
+                                           m[e] = Acc(src[e]);
+                                       }
+                                       std::fill(inv.begin(), inv.end(), Acc{});
+                                       for (size_t i{0}; i < N; i++)
+                                       {
+                                           std::fill_n(inv.data() + (i * N + i) * W, W, Acc{1});
+                                       }
+
+                                       auto element = [&](Acc *v, size_t r, size_t c)
+                                       { return v + (r * N + c) * W; };
+
+                                       Acc scale[W];
+                                       for (size_t c{0}; c < N; c++)
+                                       {
+                                           for (size_t l{0}; l < W; l++)
+                                           {
+                                               size_t p{c};
+                                               for (size_t r{c + 1}; r < N; r++)
+                                               {
+                                                   if (std::abs(element(m.data(), r, c)[l]) > std::abs(element(m.data(), p, c)[l]))
+                                                   {
+                                                       p = r;
+                                                   }
+                                               }
+                                               Acc pivot = element(m.data(), p, c)[l];
+                                               if (pivot == Acc{0})
+                                               {
+                                                   size_t const b = k * W + l;
+                                                   if (b < a.size())
+                                                   {
+                                                       throw std::domain_error("Singular matrix in batch (index " + std::to_string(b) + ")");
+                                                   }
+                                                   pivot = Acc{1}; // Padding lane past the end of the batch.
+                                               }
+                                               if (p != c)
+                                               {
+                                                   for (size_t j{0}; j < N; j++)
+                                                   {
+                                                       std::swap(element(m.data(), p, j)[l], element(m.data(), c, j)[l]);
+                                                       std::swap(element(inv.data(), p, j)[l], element(inv.data(), c, j)[l]);
+                                                   }
+                                               }
+                                               scale[l] = Acc{1} / pivot;
+                                           }
+
+                                           for (size_t j{0}; j < N; j++)
+                                           {
+                                               Acc *mc = element(m.data(), c, j);
+                                               Acc *ic = element(inv.data(), c, j);
+                                               for (size_t l{0}; l < W; l++)
+                                               {
+                                                   mc[l] *= scale[l];
+                                                   ic[l] *= scale[l];
+                                               }
+                                           }
+
+                                           for (size_t r{0}; r < N; r++)
+                                           {
+                                               if (r == c)
+                                               {
+                                                   continue;
+                                               }
+                                               Acc f[W];
+                                               std::copy_n(element(m.data(), r, c), W, f);
+                                               for (size_t j{0}; j < N; j++)
+                                               {
+                                                   Acc *mr = element(m.data(), r, j);
+                                                   Acc *ir = element(inv.data(), r, j);
+                                                   const Acc *mc = element(m.data(), c, j);
+                                                   const Acc *ic = element(inv.data(), c, j);
+                                                   for (size_t l{0}; l < W; l++)
+                                                   {
+                                                       mr[l] -= f[l] * mc[l];
+                                                       ir[l] -= f[l] * ic[l];
+                                                   }
+                                               }
+                                           }
+                                       }
+
+                                       T *dst = result.block(k);
+                                       for (size_t e{0}; e < N * N * W; e++)
+                                       {
+                                           dst[e] = T(inv[e]);
+                                       }
+                                   } });
+        return result;
+    }
+
+} // namespace matrix
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "kernels.hpp"
+#include "matrix_base.hpp"
+#include "parallel.hpp"
+#include "reduce.hpp"
+
+namespace matrix
+{
+
+    // Samples the covariance accumulator centres at a time: their block mean and centred co-moments are
+    // computed while the block is in L1, then merged into the running totals.
+    inline constexpr size_t covariance_block = 256;
+
+    // CovarianceAccumulator: Streaming count, mean and co-moment matrix (sum of (x - mean)(x - mean)^T) of
+    // D-dimensional samples, accumulated in the floating-point type A. Samples are added in blocks,
+    // each centred on its own mean, and blocks are combined with Chan's parallel update, so large
+    // offsets do not cancel and every sample is read from memory once.
+    template <class A, size_t D>
+    class CovarianceAccumulator
+    {
+        static_assert(std::is_floating_point_v<A>, "Covariances are accumulated in a floating-point type.");
+
+        // Both live on the heap: at D = 512 in double the co-moments take 2 MiB, and accumulators are
+        // built and combined on thread-pool stacks.
+        size_t count_{0};
+        std::vector<A> mean_ = std::vector<A>(D);
+        std::vector<A> m2_ = std::vector<A>(D * D); // Co-moments; only the upper triangle is accumulated.
+
+        // Merge a block of n samples with the given mean and co-moments (upper triangle).
+        void merge(size_t const n, const A *mean, const A *m2)
+        {
+            if (n == 0)
+            {
+                return;
+            }
+            size_t const total = count_ + n;
+            A const scale = A(count_) * A(n) / A(total);
+            for (size_t p{0}; p < D; p++)
+            {
+                // mean_[q] is still the old mean for q >= p.
+                A const delta = mean[p] - mean_[p];
+                for (size_t q{p}; q < D; q++)
+                {
+                    m2_[p * D + q] += m2[p * D + q] + delta * (mean[q] - mean_[q]) * scale;
+                }
+                mean_[p] += delta * (A(n) / A(total));
+            }
+            count_ = total;
+        }
+
+        // Add n <= covariance_block samples, rows of D elements stride elements apart, as one block.
+        // The block is transposed into the first D x covariance_block elements of `scratch`, so its
+        // means and co-moments are sums and dot products of contiguous columns that vectorize; the
+        // next D + D * D elements receive the block means and co-moments.
+        template <class T>
+        void add_block(const T *x, size_t const n, size_t const stride, A *scratch)
+        {
+            A *const columns = scratch;
+            A *const mean = columns + D * covariance_block;
+            A *const m2 = mean + D;
+            constexpr size_t L = detail::vector_lanes<A>;
+            for (size_t r{0}; r < n; r++)
+            {
+                for (size_t p{0}; p < D; p++)
+                {
+                    columns[p * covariance_block + r] = A(x[r * stride + p]);
+                }
+            }
+            size_t const body = n - n % L;
+            for (size_t p{0}; p < D; p++)
+            {
+                A *c = columns + p * covariance_block;
+                A lanes[L]{};
+                for (size_t k{0}; k < body; k += L)
+                {
+                    for (size_t l{0}; l < L; l++)
+                    {
+                        lanes[l] += c[k + l];
+                    }
+                }
+                A sum{};
+                for (size_t l{0}; l < L; l++)
+                {
+                    sum += lanes[l];
+                }
+                for (size_t k{body}; k < n; k++)
+                {
+                    sum += c[k];
+                }
+                A const m = sum / A(n);
+                for (size_t k{0}; k < n; k++)
+                {
+                    c[k] -= m;
+                }
+                mean[p] = m;
+            }
+            for (size_t p{0}; p < D; p++)
+            {
+                for (size_t q{p}; q < D; q++)
+                {
+                    m2[p * D + q] = detail::dot(columns + p * covariance_block, columns + q * covariance_block, n);
+                }
+            }
+            merge(n, mean, m2);
+        }
+
+    public:
+        // Add `rows` samples from an external buffer of rows D elements long, stride elements apart.
+        // Large inputs are split into row blocks that are accumulated in parallel and combined in a
+        // fixed tree, so results do not depend on the number of threads.
+        template <class T>
+        void add(const T *data, size_t const rows, size_t const stride = D)
+        {
+            if (stride < D)
+            {
+                throw std::invalid_argument("stride < D");
+            }
+            MATRIX_INSTRUMENT_SCOPE("covariance", D, D, rows, 3 * rows * D * (D + 1) / 2, rows * D * sizeof(T));
+            size_t const block = std::max(covariance_block, parallel_threshold / std::max<size_t>(1, D * D));
+            auto partial = [&](size_t r0, size_t r1)
+            {
+                CovarianceAccumulator result;
+                std::vector<A> scratch(D * covariance_block + D + D * D);
+                for (size_t r{r0}; r < r1; r += covariance_block)
+                {
+                    result.add_block(data + r * stride, std::min(covariance_block, r1 - r), stride, scratch.data());
+                }
+                return result;
+            };
+            if (rows > 0)
+            {
+                merge(detail::reduce_blocks<CovarianceAccumulator>(rows, block, partial, [](CovarianceAccumulator &&a, const CovarianceAccumulator &b)
+                                                                   {
+                                                                       a.merge(b);
+                                                                       return std::move(a); }));
+            }
+        }
+
+        // Add every row of a matrix as a sample.
+        template <class T, size_t ROW, class S>
+        void add(const SimpleMatrix<T, ROW, D, S> &m)
+        {
+            add(m.data(), ROW, m.stride());
+        }
+
+        // Merge the samples of another accumulator.
+        void merge(const CovarianceAccumulator &other)
+        {
+            merge(other.count_, other.mean_.data(), other.m2_.data());
+        }
+
+        // Number of samples added.
+        size_t count() const
+        {
+            return count_;
+        }
+
+        // Mean of the samples, as a row.
+        SimpleMatrix<A, 1, D> mean() const
+        {
+            SimpleMatrix<A, 1, D> result;
+            std::copy(mean_.begin(), mean_.end(), result.row(0));
+            return result;
+        }
+
+        // Covariance matrix: the co-moments divided by count - ddof (1 for the sample covariance, 0 for
+        // the population covariance). Throws std::domain_error unless count > ddof.
+        SimpleMatrix<A, D, D> covariance(size_t const ddof = 1) const
+        {
+            if (count_ <= ddof)
+            {
+                throw std::domain_error("Covariance needs more samples than ddof");
+            }
+            SimpleMatrix<A, D, D> result;
+            A const inv = A{1} / A(count_ - ddof);
+            for (size_t p{0}; p < D; p++)
+            {
+                for (size_t q{p}; q < D; q++)
+                {
+                    A const c = m2_[p * D + q] * inv;
+                    result.row(p)[q] = c;
+                    result.row(q)[p] = c;
+                }
+            }
+            return result;
+        }
+    }; // CovarianceAccumulator
+
+    // Covariance matrix of the rows of m as samples, in one parallel pass over the data; accumulated in
+    // the floating-point type of Acc (by default double for integers, float for half and bfloat16).
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto covariance(const SimpleMatrix<T, ROW, COL, S> &m, size_t const ddof = 1)
+    {
+        CovarianceAccumulator<detail::real_t<detail::sum_t<Acc, T>>, COL> acc;
+        acc.add(m);
+        return acc.covariance(ddof);
+    }
+
+} // namespace matrix
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "matrix.hpp"
+#include "kernels.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // How squared distances between points are computed.
+    enum class DistanceMode
+    {
+        Auto,   // Direct up to direct_distance_dims dimensions, Gemm above.
+        Direct, // sum_d (a_d - b_d)^2: three flops per dimension and never negative.
+        Gemm,   // ||a||^2 + ||b||^2 - 2 a.b: two flops per dimension, but it cancels for nearby points far
+                // from the origin; results are clamped at zero.
+    };
+
+    // Highest dimension for which DistanceMode::Auto computes distances directly.
+    inline constexpr size_t direct_distance_dims = 8;
+
+    // Bytes of B^T compared with one point of A per pass: the block stays in L1 while the rows of A
+    // stream past it.
+    inline constexpr size_t distance_tile_bytes = 32 << 10;
+
+    // Points of B in that block for D dimensions of T: a multiple of vector_block, and at least one.
+    template <class T, size_t D>
+    inline constexpr size_t distance_tile =
+        std::max(detail::vector_block, distance_tile_bytes / (std::max<size_t>(1, D) * sizeof(T)) / detail::vector_block * detail::vector_block);
+
+    // Neighbors: The K nearest points of B to each point of A, nearest first; ties keep the lower index.
+    template <class T, size_t N, size_t K>
+    struct Neighbors
+    {
+        SimpleMatrix<size_t, N, K> index; // Row of B of each neighbour.
+        SimpleMatrix<T, N, K> distance;   // Its squared distance.
+    };
+
+    namespace detail
+    {
+
+        // Points of B laid out for the distance kernels: B^T (dims x m, row stride m) and the squared
+        // norms of the points.
+        template <class T>
+        struct PointColumns
+        {
+            std::vector<T> bt;
+            std::vector<T> norms;
+        };
+
+        template <class T>
+        PointColumns<T> point_columns(const T *b, size_t const ldb, size_t const m, size_t const dims)
+        {
+            PointColumns<T> p{std::vector<T>(dims * m), std::vector<T>(m)};
+            for (size_t j{0}; j < m; j++)
+            {
+                for (size_t d{0}; d < dims; d++)
+                {
+                    p.bt[d * m + j] = b[j * ldb + d];
+                }
+                p.norms[j] = dot(b + j * ldb, b + j * ldb, dims);
+            }
+            return p;
+        }
+
+        // out[0, n) = squared distances from the point a to the n points of B whose coordinates are the
+        // columns of bt (dims x n, row stride ldb) and whose squared norms are norms[0, n) (Gemm only).
+        template <class T>
+        void distances_to(const T *a, size_t const dims, const T *__restrict bt, size_t const ldb, const T *__restrict norms,
+                          T *__restrict out, size_t const n, bool const direct)
+        {
+            if (direct)
+            {
+                std::fill(out, out + n, T{});
+                for (size_t d{0}; d < dims; d++)
+                {
+                    T const ad = a[d];
+                    const T *b = bt + d * ldb;
+                    for_each_vectorized(n, [=](size_t j)
+                                        {
+                                            T const t = ad - b[j];
+                                            out[j] += t * t; });
+                }
+                return;
+            }
+            T const norm = dot(a, a, dims);
+            for_each_vectorized(n, [=](size_t j)
+                                { out[j] = norm + norms[j]; });
+            for (size_t d{0}; d < dims; d++)
+            {
+                T const ad = T{-2} * a[d];
+                const T *b = bt + d * ldb;
+                for_each_vectorized(n, [=](size_t j)
+                                    { out[j] += ad * b[j]; });
+            }
+            for_each_vectorized(n, [=](size_t j)
+                                { out[j] = out[j] < T{} ? T{} : out[j]; });
+        }
+
+        // Candidates offered to the top k together: a block whose smallest distance cannot enter is
+        // skipped after a vectorized scan.
+        inline constexpr size_t neighbor_block = 64;
+
+        // Offer the candidates dist[0, n), which are points [j0, j0 + n) of B, to the k nearest found
+        // so far (best and index, sorted nearest first).
+        template <class T>
+        void offer_neighbors(const T *dist, size_t const n, size_t const j0, T *best, size_t *index, size_t const k)
+        {
+            constexpr size_t L = vector_lanes<T>;
+            T worst = best[k - 1];
+            for (size_t b0{0}; b0 < n; b0 += neighbor_block)
+            {
+                size_t const b1 = std::min(n, b0 + neighbor_block);
+                if (b1 - b0 == neighbor_block)
+                {
+                    T low[L];
+                    for (size_t l{0}; l < L; l++)
+                    {
+                        low[l] = dist[b0 + l];
+                    }
+                    for (size_t j{b0 + L}; j < b1; j += L)
+                    {
+                        for (size_t l{0}; l < L; l++)
+                        {
+                            low[l] = dist[j + l] < low[l] ? dist[j + l] : low[l];
+                        }
+                    }
+                    bool enters{false};
+                    for (size_t l{0}; l < L; l++)
+                    {
+                        enters |= low[l] < worst;
+                    }
+                    if (!enters)
+                    {
+                        continue;
+                    }
+                }
+                for (size_t j{b0}; j < b1; j++)
+                {
+                    T const d = dist[j];
+                    if (!(d < worst))
+                    {
+                        continue;
+                    }
+                    size_t p{k - 1};
+                    for (; p > 0 && best[p - 1] > d; p--)
+                    {
+                        best[p] = best[p - 1];
+                        index[p] = index[p - 1];
+                    }
+                    best[p] = d;
+                    index[p] = j0 + j;
+                    worst = best[k - 1];
+                }
+            }
+        }
+
+        inline bool direct_distances(DistanceMode const mode, size_t const dims)
+        {
+            return mode == DistanceMode::Direct || (mode == DistanceMode::Auto && dims <= direct_distance_dims);
+        }
+
+    } // namespace detail
+
+    // Squared Euclidean distances between the rows of A (N points) and the rows of B (M points), as an
+    // N x M matrix. Rows of the result run in parallel, a distance_tile<T, D> of B at a time.
+    template <class T, size_t N, size_t M, size_t D, class S1, class S2>
+    SimpleMatrix<T, N, M, result_layout_t<S1>> pairwise_squared_distances(const SimpleMatrix<T, N, D, S1> &a, const SimpleMatrix<T, M, D, S2> &b,
+                                                                          DistanceMode const mode = DistanceMode::Auto)
+    {
+        static_assert(std::is_floating_point_v<T>, "Distances need a floating-point element type.");
+        bool const direct = detail::direct_distances(mode, D);
+        MATRIX_INSTRUMENT_SCOPE("pairwise_squared_distances", N, M, D, (direct ? 3 : 2) * N * M * D, (N * D + M * D + N * M) * sizeof(T));
+        SimpleMatrix<T, N, M, result_layout_t<S1>> result;
+        auto const points = detail::point_columns(b.data(), b.stride(), M, D);
+        T *const out = result.data();
+        size_t const grain = std::max<size_t>(1, parallel_threshold / (M * D + 1));
+        parallel_for(0, N, grain, [&](size_t lo, size_t hi)
+                     {
+                         for (size_t j0{0}; j0 < M; j0 += distance_tile<T, D>)
+                         {
+                             size_t const n = std::min(distance_tile<T, D>, M - j0);
+                             for (size_t i{lo}; i < hi; i++)
+                             {
+                                 detail::distances_to(a.row(i), D, points.bt.data() + j0, M, points.norms.data() + j0, out + i * result.stride() + j0, n, direct);
+                             }
+                         } });
+        return result;
+    }
+
+    // The K nearest rows of B to each row of A by squared Euclidean distance (K = 1 is the argmin).
+    // Distances are computed a distance_tile<T, D> at a time into a per-thread buffer and merged into the
+    // running top K, so memory stays O(N * K) however many points B has. Rows of A run in parallel.
+    template <size_t K = 1, class T, size_t N, size_t M, size_t D, class S1, class S2>
+    Neighbors<T, N, K> nearest_neighbors(const SimpleMatrix<T, N, D, S1> &a, const SimpleMatrix<T, M, D, S2> &b,
+                                         DistanceMode const mode = DistanceMode::Auto)
+    {
+        static_assert(std::is_floating_point_v<T>, "Distances need a floating-point element type.");
+        static_assert(K >= 1 && K <= M, "K must be between 1 and the number of points in B.");
+        bool const direct = detail::direct_distances(mode, D);
+        MATRIX_INSTRUMENT_SCOPE("nearest_neighbors", N, K, M, (direct ? 3 : 2) * N * M * D, (N * D + M * D + 2 * N * K) * sizeof(T));
+        Neighbors<T, N, K> result;
+        std::fill(result.distance.begin(), result.distance.end(), std::numeric_limits<T>::infinity());
+        auto const points = detail::point_columns(b.data(), b.stride(), M, D);
+        T *const best = result.distance.data();
+        size_t *const index = result.index.data();
+        size_t const grain = std::max<size_t>(1, parallel_threshold / (M * D + 1));
+        parallel_for(0, N, grain, [&](size_t lo, size_t hi)
+                     {
+                         std::vector<T> dist(std::min(distance_tile<T, D>, M));
+                         for (size_t j0{0}; j0 < M; j0 += distance_tile<T, D>)
+                         {
+                             size_t const n = std::min(distance_tile<T, D>, M - j0);
+                             for (size_t i{lo}; i < hi; i++)
+                             {
+                                 detail::distances_to(a.row(i), D, points.bt.data() + j0, M, points.norms.data() + j0, dist.data(), n, direct);
+                                 detail::offer_neighbors(dist.data(), n, j0, best + i * result.distance.stride(), index + i * result.index.stride(), K);
+                             }
+                         } });
+        return result;
+    }
+
+} // namespace matrix
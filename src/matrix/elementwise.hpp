@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "kernels.hpp"
+#include "matrix_base.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // Execution policies of the element-wise functions, named after std::execution. (The standard
+    // policies are not accepted directly: with libstdc++, <execution> requires linking TBB.)
+    namespace execution
+    {
+
+        // In order on the calling thread.
+        struct sequenced_policy
+        {
+            static constexpr bool parallel = false;
+            static constexpr bool vectorize = false;
+        };
+
+        // On the calling thread, vectorized: calls may be interleaved, so f must not depend on their order.
+        struct unsequenced_policy
+        {
+            static constexpr bool parallel = false;
+            static constexpr bool vectorize = true;
+        };
+
+        // Row blocks of large matrices on the library thread pool, in order within a block.
+        struct parallel_policy
+        {
+            static constexpr bool parallel = true;
+            static constexpr bool vectorize = false;
+        };
+
+        // Row blocks on the thread pool, each vectorized. The default.
+        struct parallel_unsequenced_policy
+        {
+            static constexpr bool parallel = true;
+            static constexpr bool vectorize = true;
+        };
+
+        inline constexpr sequenced_policy seq{};
+        inline constexpr unsequenced_policy unseq{};
+        inline constexpr parallel_policy par{};
+        inline constexpr parallel_unsequenced_policy par_unseq{};
+
+        template <class P>
+        inline constexpr bool is_execution_policy_v = std::is_same_v<P, sequenced_policy> || std::is_same_v<P, unsequenced_policy> ||
+                                                      std::is_same_v<P, parallel_policy> || std::is_same_v<P, parallel_unsequenced_policy>;
+
+        template <class P>
+        concept policy = is_execution_policy_v<std::remove_cvref_t<P>>;
+
+    } // namespace execution
+
+    namespace detail
+    {
+
+        // The kernels below take restrict-qualified spans, so the compiler vectorizes f without alias
+        // checks; the loops without the qualifier keep the order of the calls.
+        template <class T, class U, class F>
+        void map_unseq(const T *__restrict src, U *__restrict dst, size_t const n, F &f)
+        {
+            for_each_vectorized(n, [=, &f](size_t k)
+                                { dst[k] = f(src[k]); });
+        }
+
+        template <class T1, class T2, class U, class F>
+        void zip_unseq(const T1 *__restrict a, const T2 *__restrict b, U *__restrict dst, size_t const n, F &f)
+        {
+            for_each_vectorized(n, [=, &f](size_t k)
+                                { dst[k] = f(a[k], b[k]); });
+        }
+
+        template <class T, class F>
+        void apply_unseq(T *__restrict p, size_t const n, F &f)
+        {
+            for_each_vectorized(n, [=, &f](size_t k)
+                                { p[k] = f(p[k]); });
+        }
+
+        template <class T1, class T2, class F>
+        void zip_apply_unseq(T1 *__restrict a, const T2 *__restrict b, size_t const n, F &f)
+        {
+            for_each_vectorized(n, [=, &f](size_t k)
+                                { a[k] = f(a[k], b[k]); });
+        }
+
+        // dst[k] = f(src[k]) for k < n.
+        template <class P, class T, class U, class F>
+        void map_span(const T *src, U *dst, size_t const n, F &f)
+        {
+            if constexpr (P::vectorize)
+            {
+                map_unseq(src, dst, n, f);
+            }
+            else
+            {
+                for (size_t k{0}; k < n; k++)
+                {
+                    dst[k] = f(src[k]);
+                }
+            }
+        }
+
+        // dst[k] = f(a[k], b[k]) for k < n.
+        template <class P, class T1, class T2, class U, class F>
+        void zip_span(const T1 *a, const T2 *b, U *dst, size_t const n, F &f)
+        {
+            if constexpr (P::vectorize)
+            {
+                zip_unseq(a, b, dst, n, f);
+            }
+            else
+            {
+                for (size_t k{0}; k < n; k++)
+                {
+                    dst[k] = f(a[k], b[k]);
+                }
+            }
+        }
+
+        // p[k] = f(p[k]) for k < n.
+        template <class P, class T, class F>
+        void apply_span(T *p, size_t const n, F &f)
+        {
+            if constexpr (P::vectorize)
+            {
+                apply_unseq(p, n, f);
+            }
+            else
+            {
+                for (size_t k{0}; k < n; k++)
+                {
+                    p[k] = f(p[k]);
+                }
+            }
+        }
+
+        // a[k] = f(a[k], b[k]) for k < n. When b is a itself, f sees each element twice.
+        template <class P, class T1, class T2, class F>
+        void zip_apply_span(T1 *a, const T2 *b, size_t const n, F &f)
+        {
+            if constexpr (P::vectorize)
+            {
+                if (static_cast<const void *>(a) == static_cast<const void *>(b))
+                {
+                    auto twice = [&f](T1 const x)
+                    { return f(x, x); };
+                    apply_unseq(a, n, twice);
+                }
+                else
+                {
+                    zip_apply_unseq(a, b, n, f);
+                }
+            }
+            else
+            {
+                for (size_t k{0}; k < n; k++)
+                {
+                    a[k] = f(a[k], b[k]);
+                }
+            }
+        }
+
+        // Extents that combine under broadcasting: equal, or 1 on either side.
+        constexpr bool broadcastable(size_t const a, size_t const b)
+        {
+            return a == b || a == 1 || b == 1;
+        }
+
+        // dst[k] = f(a[k], b[k]) for k < n, where an operand with a single column (C1 or C2 of 1) supplies
+        // its one element to every k. That element is captured by value and stays in a register.
+        template <class P, size_t C1, size_t C2, class T1, class T2, class U, class F>
+        void zip_broadcast(const T1 *a, const T2 *b, U *dst, size_t const n, F &f)
+        {
+            if constexpr (C1 == C2)
+            {
+                zip_span<P>(a, b, dst, n, f);
+            }
+            else if constexpr (C1 == 1)
+            {
+                auto with = [&f, x = a[0]](const T2 &y)
+                { return f(x, y); };
+                map_span<P>(b, dst, n, with);
+            }
+            else
+            {
+                auto with = [&f, y = b[0]](const T1 &x)
+                { return f(x, y); };
+                map_span<P>(a, dst, n, with);
+            }
+        }
+
+        // Call span(r, n) over every row of a ROW x COL element-wise operation: once per row, or once per
+        // row block with n spanning the whole block when every operand is contiguous (FLAT). Parallel
+        // policies split large matrices into the row blocks of for_each_row_block.
+        template <class P, size_t ROW, size_t COL, size_t STRIDE, bool FLAT, class Span>
+        void for_each_span(Span &&span)
+        {
+            auto rows = [&](size_t lo, size_t hi)
+            {
+                if constexpr (FLAT)
+                {
+                    span(lo, (hi - lo) * COL);
+                }
+                else
+                {
+                    for (size_t r{lo}; r < hi; r++)
+                    {
+                        span(r, COL);
+                    }
+                }
+            };
+            if constexpr (P::parallel)
+            {
+                for_each_row_block<ROW, STRIDE>(rows);
+            }
+            else
+            {
+                rows(0, ROW);
+            }
+        }
+
+    } // namespace detail
+
+    // Apply f to every element: result(i, j) = f(m(i, j)). The element type of the result is what f
+    // returns. f must be safe to call concurrently under the parallel policies.
+    template <execution::policy P, class T, size_t ROW, size_t COL, class S, class F>
+    auto map(P &&, const SimpleMatrix<T, ROW, COL, S> &m, F &&f)
+    {
+        using Policy = std::remove_cvref_t<P>;
+        using U = std::remove_cvref_t<std::invoke_result_t<F &, const T &>>;
+        using Result = SimpleMatrix<U, ROW, COL, result_layout_t<S>>;
+        MATRIX_INSTRUMENT_SCOPE("map", ROW, COL, 0, 0, ROW * COL * (sizeof(T) + sizeof(U)));
+
+        Result result;
+        constexpr bool flat = SimpleMatrix<T, ROW, COL, S>::contiguous && Result::contiguous;
+        detail::for_each_span<Policy, ROW, COL, Result::stride(), flat>([&](size_t r, size_t n)
+                                                                         { detail::map_span<Policy>(m.row(r), result.row(r), n, f); });
+        return result;
+    }
+
+    template <class T, size_t ROW, size_t COL, class S, class F>
+    auto map(const SimpleMatrix<T, ROW, COL, S> &m, F &&f)
+    {
+        return map(execution::par_unseq, m, f);
+    }
+
+    // Combine corresponding elements: result(i, j) = f(a(i, j), b(i, j)). Operands broadcast like NumPy
+    // arrays: an extent of 1 repeats along that axis, so b may be a row (1 x COL) or column (ROW x 1)
+    // vector, and a column vector with a row vector gives their outer combination. The repeated
+    // operand is read in place, never expanded to the full shape.
+    template <execution::policy P, class T1, class T2, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2, class F>
+        requires(detail::broadcastable(ROW1, ROW2) && detail::broadcastable(COL1, COL2))
+    auto zip_with(P &&, const SimpleMatrix<T1, ROW1, COL1, S1> &a, const SimpleMatrix<T2, ROW2, COL2, S2> &b, F &&f)
+    {
+        using Policy = std::remove_cvref_t<P>;
+        constexpr size_t ROW = std::max(ROW1, ROW2);
+        constexpr size_t COL = std::max(COL1, COL2);
+        using U = std::remove_cvref_t<std::invoke_result_t<F &, const T1 &, const T2 &>>;
+        using Result = SimpleMatrix<U, ROW, COL, result_layout_t<S1>>;
+        MATRIX_INSTRUMENT_SCOPE("zip_with", ROW, COL, 0, 0, ROW1 * COL1 * sizeof(T1) + ROW2 * COL2 * sizeof(T2) + ROW * COL * sizeof(U));
+
+        Result result;
+        constexpr bool flat = ROW1 == ROW2 && COL1 == COL2 && SimpleMatrix<T1, ROW1, COL1, S1>::contiguous &&
+                              SimpleMatrix<T2, ROW2, COL2, S2>::contiguous && Result::contiguous;
+        detail::for_each_span<Policy, ROW, COL, Result::stride(), flat>([&](size_t r, size_t n)
+                                                                         { detail::zip_broadcast<Policy, COL1, COL2>(a.row(ROW1 == 1 ? 0 : r), b.row(ROW2 == 1 ? 0 : r), result.row(r), n, f); });
+        return result;
+    }
+
+    template <class T1, class T2, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2, class F>
+        requires(detail::broadcastable(ROW1, ROW2) && detail::broadcastable(COL1, COL2))
+    auto zip_with(const SimpleMatrix<T1, ROW1, COL1, S1> &a, const SimpleMatrix<T2, ROW2, COL2, S2> &b, F &&f)
+    {
+        return zip_with(execution::par_unseq, a, b, f);
+    }
+
+    // Replace every element with f(element); never allocates.
+    template <execution::policy P, class T, size_t ROW, size_t COL, class S, class F>
+    SimpleMatrix<T, ROW, COL, S> &map_inplace(P &&, SimpleMatrix<T, ROW, COL, S> &m, F &&f)
+    {
+        using Policy = std::remove_cvref_t<P>;
+        MATRIX_INSTRUMENT_SCOPE("map_inplace", ROW, COL, 0, 0, 2 * ROW * COL * sizeof(T));
+
+        using M = SimpleMatrix<T, ROW, COL, S>;
+        T *const data = m.data(); // Once, before the threads start: this detaches shared storage.
+        detail::for_each_span<Policy, ROW, COL, M::stride(), M::contiguous>([&](size_t r, size_t n)
+                                                                             { detail::apply_span<Policy>(data + r * M::stride(), n, f); });
+        return m;
+    }
+
+    template <class T, size_t ROW, size_t COL, class S, class F>
+    SimpleMatrix<T, ROW, COL, S> &map_inplace(SimpleMatrix<T, ROW, COL, S> &m, F &&f)
+    {
+        return map_inplace(execution::par_unseq, m, f);
+    }
+
+    // Replace every element of a with f(a(i, j), b(i, j)); never allocates. b may be a itself, or a row or
+    // column vector that is broadcast across a (see zip_with), as in subtracting the column means.
+    template <execution::policy P, class T1, class T2, size_t ROW, size_t COL, size_t ROW2, size_t COL2, class S1, class S2, class F>
+        requires((ROW2 == ROW || ROW2 == 1) && (COL2 == COL || COL2 == 1))
+    SimpleMatrix<T1, ROW, COL, S1> &zip_with_inplace(P &&, SimpleMatrix<T1, ROW, COL, S1> &a, const SimpleMatrix<T2, ROW2, COL2, S2> &b, F &&f)
+    {
+        using Policy = std::remove_cvref_t<P>;
+        MATRIX_INSTRUMENT_SCOPE("zip_with_inplace", ROW, COL, 0, 0, 2 * ROW * COL * sizeof(T1) + ROW2 * COL2 * sizeof(T2));
+
+        using M = SimpleMatrix<T1, ROW, COL, S1>;
+        constexpr bool flat = ROW2 == ROW && COL2 == COL && M::contiguous && SimpleMatrix<T2, ROW2, COL2, S2>::contiguous;
+        T1 *const data = a.data(); // Once, before the threads start: this detaches shared storage.
+        detail::for_each_span<Policy, ROW, COL, M::stride(), flat>([&](size_t r, size_t n)
+                                                                    {
+                                                                        const T2 *row = b.row(ROW2 == 1 ? 0 : r);
+                                                                        if constexpr (COL2 == COL)
+                                                                        {
+                                                                            detail::zip_apply_span<Policy>(data + r * M::stride(), row, n, f);
+                                                                        }
+                                                                        else
+                                                                        {
+                                                                            auto with = [&f, y = row[0]](const T1 &x)
+                                                                            { return f(x, y); };
+                                                                            detail::apply_span<Policy>(data + r * M::stride(), n, with);
+                                                                        } });
+        return a;
+    }
+
+    template <class T1, class T2, size_t ROW, size_t COL, size_t ROW2, size_t COL2, class S1, class S2, class F>
+        requires((ROW2 == ROW || ROW2 == 1) && (COL2 == COL || COL2 == 1))
+    SimpleMatrix<T1, ROW, COL, S1> &zip_with_inplace(SimpleMatrix<T1, ROW, COL, S1> &a, const SimpleMatrix<T2, ROW2, COL2, S2> &b, F &&f)
+    {
+        return zip_with_inplace(execution::par_unseq, a, b, f);
+    }
+
+} // namespace matrix
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Set MATRIX_INSTRUMENT to 1 to count calls, time, flops, bytes and allocations of every operation.
+// With the default of 0 the MATRIX_INSTRUMENT_SCOPE markers expand to nothing and cost nothing.
+#ifndef MATRIX_INSTRUMENT
+#define MATRIX_INSTRUMENT 0
+#endif
+
+namespace matrix::instrument
+{
+
+    inline constexpr bool enabled = MATRIX_INSTRUMENT != 0;
+
+    // Shape of one operation: result rows and columns and the inner (reduction) dimension, or 0.
+    using Shape = std::array<size_t, 3>;
+
+    // Counters: Totals recorded for one operation and shape.
+    struct Counters
+    {
+        uint64_t calls{0};
+        uint64_t nanoseconds{0}; // Wall time, including nested operations.
+        uint64_t flops{0};
+        uint64_t bytes{0}; // Bytes the operation reads and writes.
+        uint64_t allocations{0};
+        uint64_t allocated_bytes{0};
+
+        Counters &operator+=(const Counters &c)
+        {
+            calls += c.calls;
+            nanoseconds += c.nanoseconds;
+            flops += c.flops;
+            bytes += c.bytes;
+            allocations += c.allocations;
+            allocated_bytes += c.allocated_bytes;
+            return *this;
+        }
+    };
+
+    // Entry: Merged counters of one operation and shape in a snapshot.
+    struct Entry
+    {
+        std::string op;
+        Shape shape;
+        Counters counters;
+    };
+
+    namespace detail
+    {
+
+        // Operation names are string literals, so the per-thread maps key on the pointer and the
+        // snapshot merges by name.
+        struct Key
+        {
+            const char *op;
+            Shape shape;
+
+            bool operator==(const Key &) const = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key &k) const
+            {
+                size_t h = std::hash<const void *>{}(k.op);
+                for (size_t d : k.shape)
+                {
+                    h = h * 1000003u ^ d;
+                }
+                return h;
+            }
+        };
+
+        using CounterMap = std::unordered_map<Key, Counters, KeyHash>;
+
+        struct ThreadCounters;
+
+        // Registry: Every live thread's counters, plus the totals of threads that have exited.
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<ThreadCounters *> threads;
+            CounterMap retired;
+        };
+
+        // Never destroyed, so threads that exit during static destruction can still retire into it.
+        inline Registry &registry()
+        {
+            static Registry *r = new Registry;
+            return *r;
+        }
+
+        // ThreadCounters: Counters written by one thread. The mutex is only contended by snapshot().
+        struct ThreadCounters
+        {
+            std::mutex mutex;
+            CounterMap counters;
+
+            ThreadCounters()
+            {
+                std::lock_guard lock(registry().mutex);
+                registry().threads.push_back(this);
+            }
+
+            ~ThreadCounters()
+            {
+                auto &r = registry();
+                std::lock_guard lock(r.mutex);
+                for (auto const &[key, c] : counters)
+                {
+                    r.retired[key] += c;
+                }
+                r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+            }
+        };
+
+        inline ThreadCounters &thread_counters()
+        {
+            thread_local ThreadCounters counters;
+            return counters;
+        }
+
+    } // namespace detail
+
+    // Scope: Records one call of an operation from construction to destruction. Allocations reported
+    // while it is the innermost scope of its thread are charged to it.
+    class Scope
+    {
+        using clock = std::chrono::steady_clock;
+
+        detail::Key key_;
+        Counters counters_;
+        Scope *parent_;
+        clock::time_point start_;
+
+        static Scope *&current()
+        {
+            thread_local Scope *scope{nullptr};
+            return scope;
+        }
+
+    public:
+        Scope(const char *op, Shape const shape, uint64_t const flops, uint64_t const bytes)
+            : key_{op, shape}, counters_{1, 0, flops, bytes, 0, 0}, parent_(std::exchange(current(), this)), start_(clock::now())
+        {
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope()
+        {
+            counters_.nanoseconds = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+            current() = parent_;
+            auto &t = detail::thread_counters();
+            std::lock_guard lock(t.mutex);
+            t.counters[key_] += counters_;
+        }
+
+        // Charge an allocation of `bytes` to the innermost scope of the calling thread, if any.
+        static void allocation(size_t const bytes)
+        {
+            if (Scope *s = current())
+            {
+                s->counters_.allocations++;
+                s->counters_.allocated_bytes += bytes;
+            }
+        }
+    };
+
+    // Merge the counters of all threads, ordered by descending time.
+    inline std::vector<Entry> snapshot()
+    {
+        std::map<std::pair<std::string, Shape>, Counters> merged;
+        auto &r = detail::registry();
+        {
+            std::lock_guard lock(r.mutex);
+            for (auto const &[key, c] : r.retired)
+            {
+                merged[{key.op, key.shape}] += c;
+            }
+            for (auto *t : r.threads)
+            {
+                std::lock_guard thread_lock(t->mutex);
+                for (auto const &[key, c] : t->counters)
+                {
+                    merged[{key.op, key.shape}] += c;
+                }
+            }
+        }
+
+        std::vector<Entry> result;
+        for (auto const &[key, c] : merged)
+        {
+            result.push_back({key.first, key.second, c});
+        }
+        std::stable_sort(result.begin(), result.end(), [](const Entry &a, const Entry &b)
+                         { return a.counters.nanoseconds > b.counters.nanoseconds; });
+        return result;
+    }
+
+    // Clear the counters of all threads.
+    inline void reset()
+    {
+        auto &r = detail::registry();
+        std::lock_guard lock(r.mutex);
+        r.retired.clear();
+        for (auto *t : r.threads)
+        {
+            std::lock_guard thread_lock(t->mutex);
+            t->counters.clear();
+        }
+    }
+
+    // Print a snapshot as a table: operation, shape, calls, time, throughput, traffic and allocations.
+    inline void dump(std::ostream &os, const std::vector<Entry> &entries = snapshot())
+    {
+        auto const flags = os.flags();
+        auto const precision = os.precision();
+        os << std::left << std::setw(22) << "op" << std::setw(22) << "shape" << std::right
+           << std::setw(10) << "calls" << std::setw(12) << "ms" << std::setw(10) << "GFLOP/s"
+           << std::setw(10) << "GB/s" << std::setw(10) << "allocs" << std::setw(14) << "alloc bytes" << "\n";
+        for (auto const &e : entries)
+        {
+            auto const &c = e.counters;
+            double const seconds = double(c.nanoseconds) * 1e-9;
+            std::string shape = std::to_string(e.shape[0]) + "x" + std::to_string(e.shape[1]);
+            if (e.shape[2] != 0)
+            {
+                shape += " (k=" + std::to_string(e.shape[2]) + ")";
+            }
+            os << std::left << std::setw(22) << e.op << std::setw(22) << shape << std::right
+               << std::setw(10) << c.calls << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1e3
+               << std::setw(10) << std::setprecision(2) << (seconds > 0 ? double(c.flops) / seconds * 1e-9 : 0.0)
+               << std::setw(10) << (seconds > 0 ? double(c.bytes) / seconds * 1e-9 : 0.0)
+               << std::setw(10) << c.allocations << std::setw(14) << c.allocated_bytes << "\n";
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+} // namespace matrix::instrument
+
+// Mark the enclosing block as one call of `op` on a rows x cols result with inner dimension `inner`.
+// The arguments are not evaluated when instrumentation is disabled.
+#if MATRIX_INSTRUMENT
+#define MATRIX_INSTRUMENT_SCOPE(op, rows, cols, inner, flops, bytes) \
+    ::matrix::instrument::Scope matrix_instrument_scope_(op, {size_t(rows), size_t(cols), size_t(inner)}, uint64_t(flops), uint64_t(bytes))
+#define MATRIX_INSTRUMENT_ALLOCATION(bytes) ::matrix::instrument::Scope::allocation(bytes)
+#else
+#define MATRIX_INSTRUMENT_SCOPE(op, rows, cols, inner, flops, bytes) ((void)0)
+#define MATRIX_INSTRUMENT_ALLOCATION(bytes) ((void)0)
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+namespace matrix::detail
+{
+
+    // Partial sums kept by the reduction kernels: one 32-byte vector of T. Floating-point sums only
+    // vectorize when the lanes are explicit, and the compiler may not reassociate a single running sum.
+    template <class T>
+    inline constexpr size_t vector_lanes = std::max<size_t>(1, 32 / sizeof(T));
+
+    // Dot product of two contiguous spans, over vector_lanes<T> independent partial sums.
+    template <class T>
+    T dot(const T *a, const T *b, size_t n)
+    {
+        constexpr size_t L = vector_lanes<T>;
+        T acc[L]{};
+        size_t const body = n - n % L;
+        for (size_t k{0}; k < body; k += L)
+        {
+            for (size_t l{0}; l < L; l++)
+            {
+                acc[l] += a[k + l] * b[k + l];
+            }
+        }
+        T sum{};
+        for (size_t l{0}; l < L; l++)
+        {
+            sum += acc[l];
+        }
+        for (size_t k{body}; k < n; k++)
+        {
+            sum += a[k] * b[k];
+        }
+        return sum;
+    }
+
+    // Loops that should vectorize run over blocks of this many elements and then a scalar tail: at -O2,
+    // GCC only vectorizes loops whose trip count is known to be a multiple of the vector length (and
+    // whose stores cannot alias their loads).
+    inline constexpr size_t vector_block = 16;
+
+    // Call body(k) for every k in [0, n): whole vector_block blocks first, then the remaining tail.
+    // The calls must be independent and the elements they write must not be read by other calls, as
+    // restrict-qualified spans promise; restrict does not survive the inlining of body, so the block
+    // loop is marked free of dependencies instead. Capture pointers and scalars by value, so the
+    // compiler can see that they do not change inside the loop.
+    template <class F>
+    inline void for_each_vectorized(size_t const n, F &&body)
+    {
+        size_t const end = n - n % vector_block;
+        for (size_t k{0}; k < end; k += vector_block)
+        {
+#if defined(__clang__)
+#pragma clang loop vectorize(assume_safety)
+#elif defined(__GNUC__)
+#pragma GCC ivdep
+#endif
+            for (size_t l{0}; l < vector_block; l++)
+            {
+                body(k + l);
+            }
+        }
+        for (size_t k{end}; k < n; k++)
+        {
+            body(k);
+        }
+    }
+
+    // y += alpha * x over contiguous, non-overlapping spans. A non-zero ALIGN promises both spans start
+    // on that boundary.
+    template <size_t ALIGN = 0, class T>
+    void axpy(T alpha, const T *__restrict x, T *__restrict y, size_t n)
+    {
+        if constexpr (ALIGN != 0)
+        {
+            x = std::assume_aligned<ALIGN>(x);
+            y = std::assume_aligned<ALIGN>(y);
+        }
+        for_each_vectorized(n, [=](size_t k)
+                            { y[k] += alpha * x[k]; });
+    }
+
+    // Rows of A that the GEMV kernels process together, so every load of x or y serves all of them.
+    inline constexpr size_t gemv_rows = 4;
+
+    // y[r * incy] = dot(row r of A, x) for the R rows of the n-column A starting at a (row stride lda).
+    template <size_t R, class T>
+    void gemv_block(const T *a, size_t lda, const T *x, T *y, size_t incy, size_t n)
+    {
+        constexpr size_t L = vector_lanes<T>;
+        T acc[R][L]{};
+        size_t const body = n - n % L;
+        for (size_t k{0}; k < body; k += L)
+        {
+            for (size_t r{0}; r < R; r++)
+            {
+                for (size_t l{0}; l < L; l++)
+                {
+                    acc[r][l] += a[r * lda + k + l] * x[k + l];
+                }
+            }
+        }
+        for (size_t r{0}; r < R; r++)
+        {
+            T sum{};
+            for (size_t l{0}; l < L; l++)
+            {
+                sum += acc[r][l];
+            }
+            for (size_t k{body}; k < n; k++)
+            {
+                sum += a[r * lda + k] * x[k];
+            }
+            y[r * incy] = sum;
+        }
+    }
+
+    // y[0, n) += x[0] * row 0 + ... + x[R - 1] * row R - 1 of the A starting at a (row stride lda): a
+    // block of A^T * x, with each element of y loaded and stored once for R rows.
+    template <size_t R, class T>
+    void gemv_t_block(const T *__restrict a, size_t lda, const T *x, size_t incx, T *__restrict y, size_t n)
+    {
+        T xr[R];
+        for (size_t r{0}; r < R; r++)
+        {
+            xr[r] = x[r * incx];
+        }
+        // The body works on vector_block elements of y at a time, held in explicit lanes so the loop
+        // over them, not the short loop over the rows, is the one that vectorizes.
+        size_t const body = n - n % vector_block;
+        for (size_t k{0}; k < body; k += vector_block)
+        {
+            T acc[vector_block];
+            for (size_t l{0}; l < vector_block; l++)
+            {
+                acc[l] = y[k + l];
+            }
+            for (size_t r{0}; r < R; r++)
+            {
+                for (size_t l{0}; l < vector_block; l++)
+                {
+                    acc[l] += xr[r] * a[r * lda + k + l];
+                }
+            }
+            for (size_t l{0}; l < vector_block; l++)
+            {
+                y[k + l] = acc[l];
+            }
+        }
+        for (size_t k{body}; k < n; k++)
+        {
+            T sum = y[k];
+            for (size_t r{0}; r < R; r++)
+            {
+                sum += xr[r] * a[r * lda + k];
+            }
+            y[k] = sum;
+        }
+    }
+
+} // namespace matrix::detail
@@ -1,6 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 #include "matrix_base.hpp" // Include necessary dependencies.
+#include "kernels.hpp"
+#include "parallel.hpp"
+#include "reduce.hpp"
+#include "elementwise.hpp"
+#include "ranges.hpp"
 
 namespace matrix
 {
@@ -12,60 +23,408 @@ namespace matrix
         (..., matrix.print()); // Use a fold expression to call print() on each matrix.
     }
 
-    // Function to resize a matrix to a new size.
-    template <size_t NEW_ROW, size_t NEW_COL, class T, size_t ROW, size_t COL>
-    auto resize(const SimpleMatrix<T, ROW, COL> &m)
+    namespace detail
     {
-        SimpleMatrix<T, NEW_ROW, NEW_COL> result;
 
-        for (size_t i{0}; i < ROW; i++)
+        // Block sizes of the generic multiply: a gemm_kc x gemm_nc panel of B stays in L2 while every
+        // row of A in the thread's range streams past it.
+        inline constexpr size_t gemm_kc = 128;
+        inline constexpr size_t gemm_nc = 512;
+
+        // C += A * B for m x k A and k x n B with the given row strides. Rows of C are split across
+        // threads; each row is updated with contiguous axpys over B rows (i-k-j order), so the inner
+        // loop never walks down a column. ALIGN is the row alignment guaranteed for all three operands.
+        template <size_t ALIGN, class T>
+        void multiply(const T *a, size_t lda, const T *b, size_t ldb, T *c, size_t ldc, size_t m, size_t k, size_t n)
+        {
+            size_t const grain = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, k * n));
+            parallel_for(0, m, grain, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t j0{0}; j0 < n; j0 += gemm_nc)
+                             {
+                                 size_t const j1 = std::min(n, j0 + gemm_nc);
+                                 for (size_t k0{0}; k0 < k; k0 += gemm_kc)
+                                 {
+                                     size_t const k1 = std::min(k, k0 + gemm_kc);
+                                     for (size_t i{lo}; i < hi; i++)
+                                     {
+                                         const T *ai = a + i * lda;
+                                         T *ci = c + i * ldc + j0;
+                                         for (size_t kk{k0}; kk < k1; kk++)
+                                         {
+                                             axpy<ALIGN>(ai[kk], b + kk * ldb + j0, ci, j1 - j0);
+                                         }
+                                     }
+                                 }
+                             } });
+        }
+
+        // C = A * B for compact element types. B is widened once, then every row of A is widened and
+        // accumulated in float against it, so each stored value is rounded exactly once.
+        template <class T, size_t ROW1, size_t COL1, size_t COL2>
+        void compact_multiply(const T *a, size_t lda, const T *b, size_t ldb, T *c, size_t ldc)
+        {
+            using Acc = accumulator_t<T>;
+
+            std::vector<Acc> wb(COL1 * COL2);
+            for (size_t k{0}; k < COL1; k++)
+            {
+                widen(b + k * ldb, wb.data() + k * COL2, COL2);
+            }
+
+            size_t const grain = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, COL1 * COL2));
+            parallel_for(0, ROW1, grain, [&](size_t lo, size_t hi)
+                         {
+                             std::vector<Acc> wa(COL1);
+                             std::vector<Acc> acc(COL2);
+                             for (size_t i{lo}; i < hi; i++)
+                             {
+                                 widen(a + i * lda, wa.data(), COL1);
+                                 std::fill(acc.begin(), acc.end(), Acc{});
+                                 for (size_t k{0}; k < COL1; k++)
+                                 {
+                                     axpy(wa[k], wb.data() + k * COL2, acc.data(), COL2);
+                                 }
+                                 narrow(acc.data(), c + i * ldc, COL2);
+                             } });
+        }
+
+        // Contiguous copy of the n elements x[0], x[inc], ... in `buffer`, or x itself when inc is 1.
+        template <class T>
+        const T *packed(const T *x, size_t const inc, size_t const n, std::vector<T> &buffer)
+        {
+            if (inc == 1)
+            {
+                return x;
+            }
+            buffer.resize(n);
+            for (size_t k{0}; k < n; k++)
+            {
+                buffer[k] = x[k * inc];
+            }
+            return buffer.data();
+        }
+
+        // y = A * x for the m x n A (row stride lda); x and y step by incx and incy. Row blocks run in
+        // parallel, gemv_rows rows at a time.
+        template <class T>
+        void gemv(const T *a, size_t lda, const T *x, size_t incx, T *y, size_t incy, size_t m, size_t n)
+        {
+            std::vector<T> buffer;
+            x = packed(x, incx, n, buffer);
+            size_t const grain = std::max<size_t>(gemv_rows, parallel_threshold / std::max<size_t>(1, n));
+            parallel_for(0, m, grain, [&](size_t lo, size_t hi)
+                         {
+                             size_t i{lo};
+                             for (; i + gemv_rows <= hi; i += gemv_rows)
+                             {
+                                 gemv_block<gemv_rows>(a + i * lda, lda, x, y + i * incy, incy, n);
+                             }
+                             for (; i < hi; i++)
+                             {
+                                 gemv_block<1>(a + i * lda, lda, x, y + i * incy, incy, n);
+                             } });
+        }
+
+        // Columns of y = A^T * x updated per pass over the rows of A, so that slice of y stays in L1 while
+        // the rows stream through in long runs the prefetcher can follow.
+        inline constexpr size_t gemv_t_cols = 4096;
+
+        // y = A^T * x for the m x n A (row stride lda). Each thread takes one contiguous column range
+        // of y, so it streams its slice of all rows once and no partial results need combining.
+        template <class T>
+        void gemv_t(const T *a, size_t lda, const T *x, size_t incx, T *y, size_t incy, size_t m, size_t n)
         {
-            for (size_t j{0}; j < COL; j++)
+            std::vector<T> buffer;
+            T *out = y;
+            if (incy != 1)
+            {
+                buffer.resize(n);
+                out = buffer.data();
+            }
+            size_t const threads = ThreadPool::instance().size();
+            size_t const grain = std::max({4 * vector_block, parallel_threshold / std::max<size_t>(1, m), (n + threads - 1) / threads});
+            parallel_for(0, n, grain, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t c0{lo}; c0 < hi; c0 += gemv_t_cols)
+                             {
+                                 size_t const c1 = std::min(hi, c0 + gemv_t_cols);
+                                 std::fill(out + c0, out + c1, T{});
+                                 size_t i{0};
+                                 for (; i + gemv_rows <= m; i += gemv_rows)
+                                 {
+                                     gemv_t_block<gemv_rows>(a + i * lda + c0, lda, x + i * incx, incx, out + c0, c1 - c0);
+                                 }
+                                 for (; i < m; i++)
+                                 {
+                                     gemv_t_block<1>(a + i * lda + c0, lda, x + i * incx, incx, out + c0, c1 - c0);
+                                 }
+                             } });
+            for (size_t k{0}; out != y && k < n; k++)
+            {
+                y[k * incy] = out[k];
+            }
+        }
+
+        // A += alpha * x * y^T for the m x n A (row stride lda): one axpy of y per row, rows in parallel.
+        template <class T>
+        void ger(T alpha, const T *x, size_t incx, const T *y, size_t incy, T *a, size_t lda, size_t m, size_t n)
+        {
+            std::vector<T> buffer;
+            y = packed(y, incy, n, buffer);
+            size_t const grain = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, n));
+            parallel_for(0, m, grain, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t i{lo}; i < hi; i++)
+                             {
+                                 axpy(alpha * x[i * incx], y, a + i * lda, n);
+                             } });
+        }
+
+        // Copy one row of cols elements: memcpy for trivially copyable types.
+        template <class T>
+        void copy_row(const T *src, T *dst, size_t cols)
+        {
+            if constexpr (std::is_trivially_copyable_v<T>)
+            {
+                std::memcpy(dst, src, cols * sizeof(T));
+            }
+            else
+            {
+                std::copy_n(src, cols, dst);
+            }
+        }
+
+        // Copy a rows x cols block between row-major buffers with the given row strides. Trivially
+        // copyable rows are copied with memcpy; large blocks are split into row ranges across threads.
+        template <class T>
+        void copy_block(const T *src, size_t src_stride, T *dst, size_t dst_stride, size_t rows, size_t cols)
+        {
+            auto copy_rows = [&](size_t lo, size_t hi)
+            {
+                for (size_t i{lo}; i < hi; i++)
+                {
+                    copy_row(src + i * src_stride, dst + i * dst_stride, cols);
+                }
+            };
+
+            if (rows * cols >= parallel_threshold)
+            {
+                parallel_for(0, rows, std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, cols)), copy_rows);
+            }
+            else
+            {
+                copy_rows(0, rows);
+            }
+        }
+
+        // One source of an assembled matrix: its rows x cols block goes to (row0, col0) of the result.
+        template <class T>
+        struct BlockCopy
+        {
+            const T *src;
+            size_t stride;
+            size_t rows;
+            size_t cols;
+            size_t row0;
+            size_t col0;
+        };
+
+        template <class T, size_t ROW, size_t COL, class S>
+        BlockCopy<T> block_copy(const SimpleMatrix<T, ROW, COL, S> &m, size_t row0, size_t col0)
+        {
+            return {m.data(), m.stride(), ROW, COL, row0, col0};
+        }
+
+        // Copy every source block into the rows x cols dst (row stride ld) in a single pass over its
+        // rows; large results are split into row ranges across threads, each copying its part of every
+        // block that overlaps it.
+        template <class T, size_t N>
+        void assemble(const std::array<BlockCopy<T>, N> &blocks, T *dst, size_t ld, size_t rows, size_t cols)
+        {
+            auto copy_rows = [&](size_t lo, size_t hi)
+            {
+                for (const BlockCopy<T> &b : blocks)
+                {
+                    size_t const r1 = std::min(hi, b.row0 + b.rows);
+                    for (size_t i{std::max(lo, b.row0)}; i < r1; i++)
+                    {
+                        copy_row(b.src + (i - b.row0) * b.stride, dst + i * ld + b.col0, b.cols);
+                    }
+                }
+            };
+
+            if (rows * cols >= parallel_threshold)
+            {
+                parallel_for(0, rows, std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, cols)), copy_rows);
+            }
+            else
             {
-                result[i][j] = m.at(i, j); // Copy elements from the original matrix.
+                copy_rows(0, rows);
             }
         }
 
+        // Shape of one row of blocks passed to block(): a tuple of matrices (e.g. from std::tie).
+        template <class M>
+        struct block_shape;
+
+        template <class T, size_t ROW, size_t COL, class S>
+        struct block_shape<SimpleMatrix<T, ROW, COL, S>>
+        {
+            using value_type = T;
+            using layout = S;
+            static constexpr size_t rows = ROW;
+            static constexpr size_t cols = COL;
+        };
+
+        template <class Row>
+        struct block_row_shape;
+
+        template <class M, class... Ms>
+        struct block_row_shape<std::tuple<M, Ms...>>
+        {
+            using first = block_shape<std::remove_cvref_t<M>>;
+            using value_type = typename first::value_type;
+            using layout = typename first::layout;
+            static constexpr size_t count = 1 + sizeof...(Ms);
+            static constexpr size_t rows = std::max({first::rows, block_shape<std::remove_cvref_t<Ms>>::rows...});
+            static constexpr size_t cols = (first::cols + ... + block_shape<std::remove_cvref_t<Ms>>::cols);
+            static constexpr size_t elements = ((first::rows * first::cols) + ... + (block_shape<std::remove_cvref_t<Ms>>::rows * block_shape<std::remove_cvref_t<Ms>>::cols));
+            static constexpr bool same_type = (std::is_same_v<value_type, typename block_shape<std::remove_cvref_t<Ms>>::value_type> && ...);
+        };
+
+    } // namespace detail
+
+    // Function to resize a matrix to a new size. Elements outside the original matrix are
+    // value-initialized; rows and columns beyond the new size are dropped.
+    template <size_t NEW_ROW, size_t NEW_COL, class T, size_t ROW, size_t COL, class S>
+    auto resize(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("resize", NEW_ROW, NEW_COL, 0, 0, (std::min(ROW, NEW_ROW) * std::min(COL, NEW_COL) + NEW_ROW * NEW_COL) * sizeof(T));
+        SimpleMatrix<T, NEW_ROW, NEW_COL, result_layout_t<S>> result;
+
+        // Copy the overlapping block row by row; the constructor has already zeroed the padding.
+        detail::copy_block(m.data(), m.stride(), result.data(), result.stride(), std::min(ROW, NEW_ROW), std::min(COL, NEW_COL));
+
+        return result;
+    }
+
+    // Convert every element of a matrix to another element type (e.g. float <-> half).
+    template <class U, class T, size_t ROW, size_t COL, class S>
+    SimpleMatrix<U, ROW, COL, result_layout_t<S>> matrix_cast(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("matrix_cast", ROW, COL, 0, 0, ROW * COL * (sizeof(T) + sizeof(U)));
+        SimpleMatrix<U, ROW, COL, result_layout_t<S>> result;
+        for (size_t i{0}; i < ROW; i++)
+        {
+            const T *src = m.row(i);
+            U *dst = result.row(i);
+            if constexpr (is_compact_float_v<T> && std::is_same_v<U, float>)
+            {
+                detail::widen(src, dst, COL);
+            }
+            else if constexpr (is_compact_float_v<U> && std::is_same_v<T, float>)
+            {
+                detail::narrow(src, dst, COL);
+            }
+            else
+            {
+                std::transform(src, src + COL, dst, [](const T &x)
+                               { return static_cast<U>(x); });
+            }
+        }
         return result;
     }
 
-    // Matrix multiplication operator.
-    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2>
-    auto operator*(const SimpleMatrix<T, ROW1, COL1> &a, const SimpleMatrix<T, ROW2, COL2> &b)
+    // Matrix-vector product A * x for a column vector x.
+    template <class T, size_t ROW, size_t COL, class S1, class S2>
+    SimpleMatrix<T, ROW, 1, result_layout_t<S1>> gemv(const SimpleMatrix<T, ROW, COL, S1> &a, const SimpleMatrix<T, COL, 1, S2> &x)
+    {
+        static_assert(!is_compact_float_v<T>, "Widen compact matrices with matrix_cast first.");
+        MATRIX_INSTRUMENT_SCOPE("gemv", ROW, 1, COL, 2 * ROW * COL, (ROW * COL + COL + ROW) * sizeof(T));
+        SimpleMatrix<T, ROW, 1, result_layout_t<S1>> y;
+        detail::gemv(a.data(), a.stride(), x.data(), x.stride(), y.data(), y.stride(), ROW, COL);
+        return y;
+    }
+
+    // Transposed matrix-vector product A^T * x for a column vector x, without forming A^T.
+    template <class T, size_t ROW, size_t COL, class S1, class S2>
+    SimpleMatrix<T, COL, 1, result_layout_t<S1>> gemv_transposed(const SimpleMatrix<T, ROW, COL, S1> &a, const SimpleMatrix<T, ROW, 1, S2> &x)
+    {
+        static_assert(!is_compact_float_v<T>, "Widen compact matrices with matrix_cast first.");
+        MATRIX_INSTRUMENT_SCOPE("gemv_transposed", COL, 1, ROW, 2 * ROW * COL, (ROW * COL + COL + ROW) * sizeof(T));
+        SimpleMatrix<T, COL, 1, result_layout_t<S1>> y;
+        detail::gemv_t(a.data(), a.stride(), x.data(), x.stride(), y.data(), y.stride(), ROW, COL);
+        return y;
+    }
+
+    // Rank-1 update A += alpha * x * y^T for column vectors x and y; never allocates for contiguous y.
+    template <class T, size_t ROW, size_t COL, class S, class S1, class S2>
+    SimpleMatrix<T, ROW, COL, S> &rank1_update(SimpleMatrix<T, ROW, COL, S> &a, T const alpha, const SimpleMatrix<T, ROW, 1, S1> &x,
+                                               const SimpleMatrix<T, COL, 1, S2> &y)
+    {
+        static_assert(!is_compact_float_v<T>, "Widen compact matrices with matrix_cast first.");
+        MATRIX_INSTRUMENT_SCOPE("rank1_update", ROW, COL, 1, 2 * ROW * COL, (2 * ROW * COL + ROW + COL) * sizeof(T));
+        T *const data = a.data(); // Once, before the threads start: this detaches shared storage.
+        detail::ger(alpha, x.data(), x.stride(), y.data(), y.stride(), data, a.stride(), ROW, COL);
+        return a;
+    }
+
+    // Matrix multiplication operator. When one dimension is 1 the product is a matrix-vector product
+    // (A * x or x^T * A) or an outer product (x * y^T), and it runs the bandwidth-bound kernels
+    // for those instead of the general multiply.
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2>
+    auto operator*(const SimpleMatrix<T, ROW1, COL1, S1> &a, const SimpleMatrix<T, ROW2, COL2, S2> &b)
     {
         static_assert(COL1 == ROW2, "Matrix dimensions are incompatible for multiplication.");
+        MATRIX_INSTRUMENT_SCOPE("multiply", ROW1, COL2, COL1, 2 * ROW1 * COL1 * COL2, (ROW1 * COL1 + COL1 * COL2 + ROW1 * COL2) * sizeof(T));
 
         size_t const ROW3 = ROW1;
         size_t const COL3 = COL2;
 
-        SimpleMatrix<T, ROW3, COL3> result;
+        using Result = SimpleMatrix<T, ROW3, COL3, result_layout_t<S1>>;
+        Result result;
 
-        for (size_t i{0}; i < ROW1; ++i)
+        if constexpr (is_compact_float_v<T>)
         {
-            for (size_t j{0}; j < COL2; ++j)
-            {
-                for (size_t k{0}; k < COL1; ++k)
-                {
-                    result[i][j] += a.at(i, k) * b.at(k, j); // Perform matrix multiplication.
-                }
-            }
+            detail::compact_multiply<T, ROW1, COL1, COL2>(a.data(), a.stride(), b.data(), b.stride(), result.data(), result.stride());
+        }
+        else if constexpr (COL2 == 1)
+        {
+            detail::gemv(a.data(), a.stride(), b.data(), b.stride(), result.data(), result.stride(), ROW1, COL1);
+        }
+        else if constexpr (ROW1 == 1)
+        {
+            // x^T * B is (B^T * x)^T.
+            detail::gemv_t(b.data(), b.stride(), a.data(), size_t{1}, result.data(), size_t{1}, ROW2, COL2);
+        }
+        else if constexpr (COL1 == 1)
+        {
+            detail::ger(T{1}, a.data(), a.stride(), b.data(), size_t{1}, result.data(), result.stride(), ROW1, COL2);
+        }
+        else
+        {
+            // Aligned loads and stores are only promised when every row of B and C starts on a boundary.
+            constexpr size_t ALIGN = std::min(SimpleMatrix<T, ROW2, COL2, S2>::row_alignment, Result::row_alignment);
+            detail::multiply<ALIGN>(a.data(), a.stride(), b.data(), b.stride(), result.data(), result.stride(), ROW1, COL1, COL2);
         }
 
         return result;
     }
 
     // Matrix addition operator.
-    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2>
-    auto operator+(const SimpleMatrix<T, ROW1, COL1> &a_, const SimpleMatrix<T, ROW2, COL2> &b_)
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2>
+    auto operator+(const SimpleMatrix<T, ROW1, COL1, S1> &a_, const SimpleMatrix<T, ROW2, COL2, S2> &b_)
     {
         size_t const ROW3 = std::max(ROW1, ROW2);
         size_t const COL3 = std::max(COL1, COL2);
+        MATRIX_INSTRUMENT_SCOPE("add", ROW3, COL3, 0, ROW3 * COL3, (ROW1 * COL1 + ROW2 * COL2 + ROW3 * COL3) * sizeof(T));
 
         // Resize matrices a_ and b_ to match the dimensions of the result.
         auto a = resize<ROW3, COL3>(a_);
         auto b = resize<ROW3, COL3>(b_);
 
-        SimpleMatrix<T, ROW3, COL3> result;
+        SimpleMatrix<T, ROW3, COL3, result_layout_t<S1>> result;
 
         for (size_t i{0}; i < ROW3; i++)
         {
@@ -78,32 +437,60 @@ namespace matrix
         return result;
     };
 
-    // Matrix concatenation operator.
-    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2>
-    auto operator|(const SimpleMatrix<T, ROW1, COL1> &a, const SimpleMatrix<T, ROW2, COL2> &b)
+    // Assemble a matrix from rows of blocks, e.g. block(std::tie(a, b), std::tie(c, d)) for
+    // [a b; c d]. Each row of blocks is as tall as its tallest block and the result as wide as its
+    // widest row; uncovered elements are value-initialized. The shape is computed at compile time,
+    // the result is allocated once and every source row is copied once, in parallel for large results.
+    template <class... Rows>
+    auto block(const Rows &...rows)
     {
-        size_t const ROW3 = std::max(ROW1, ROW2);
-        size_t const COL3 = COL1 + COL2;
-
-        SimpleMatrix<T, ROW3, COL3> result;
+        static_assert(sizeof...(Rows) > 0, "block() needs at least one row of blocks.");
+        using First = detail::block_row_shape<std::tuple_element_t<0, std::tuple<Rows...>>>;
+        using T = typename First::value_type;
+        static_assert(((detail::block_row_shape<Rows>::same_type && std::is_same_v<T, typename detail::block_row_shape<Rows>::value_type>) && ...),
+                      "Blocks must share an element type.");
+        constexpr size_t ROW = (detail::block_row_shape<Rows>::rows + ...);
+        constexpr size_t COL = std::max({detail::block_row_shape<Rows>::cols...});
+        MATRIX_INSTRUMENT_SCOPE("concat", ROW, COL, 0, 0, ((detail::block_row_shape<Rows>::elements + ...) + ROW * COL) * sizeof(T));
 
-        for (size_t i{0}; i < ROW1; i++)
+        std::array<detail::BlockCopy<T>, (detail::block_row_shape<Rows>::count + ...)> blocks;
+        size_t n{0};
+        size_t row0{0};
+        auto place_row = [&](const auto &row)
         {
-            for (size_t j{0}; j < COL1; j++)
-            {
-                result[i][j] = a.at(i, j); // Copy elements from the first matrix.
-            }
-        }
-
-        for (size_t i{0}; i < ROW2; i++)
-        {
-            for (size_t j{0}; j < COL2; j++)
-            {
-                result[i][COL1 + j] = b.at(i, j); // Copy elements from the second matrix.
-            }
-        }
+            size_t col0{0};
+            std::apply([&](const auto &...ms)
+                       { ((blocks[n++] = detail::block_copy(ms, row0, std::exchange(col0, col0 + detail::block_shape<std::remove_cvref_t<decltype(ms)>>::cols))), ...); },
+                       row);
+            row0 += detail::block_row_shape<std::remove_cvref_t<decltype(row)>>::rows;
+        };
+        (place_row(rows), ...);
 
+        SimpleMatrix<T, ROW, COL, result_layout_t<typename First::layout>> result;
+        detail::assemble(blocks, result.data(), result.stride(), ROW, COL);
         return result;
+    }
+
+    // Concatenate matrices side by side: as many rows as the tallest, zeros below the shorter ones.
+    template <class T, size_t... ROW, size_t... COL, class... S>
+    auto hconcat(const SimpleMatrix<T, ROW, COL, S> &...ms)
+    {
+        return block(std::tie(ms...));
+    }
+
+    // Stack matrices on top of each other: as many columns as the widest, zeros right of the narrower.
+    template <class T, size_t... ROW, size_t... COL, class... S>
+    auto vconcat(const SimpleMatrix<T, ROW, COL, S> &...ms)
+    {
+        return block(std::tie(ms)...);
+    }
+
+    // Matrix concatenation operator: hconcat of two matrices. Chains of | copy the left operands once
+    // per operator; hconcat(a, b, c) copies each once.
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2>
+    auto operator|(const SimpleMatrix<T, ROW1, COL1, S1> &a, const SimpleMatrix<T, ROW2, COL2, S2> &b)
+    {
+        return hconcat(a, b);
     };
 
 } // matrix
@@ -5,7 +5,14 @@
 #include <stdexcept>
 #include <algorithm>
 #include <iomanip>
+#include <memory>
+#include <functional>
 #include <ranges>
+#include <span>
+#include <utility>
+
+#include "numeric.hpp"
+#include "storage.hpp"
 
 namespace matrix
 {
@@ -14,15 +21,15 @@ namespace matrix
   template <typename T, size_t COL>
   class AccessProxy
   {
-    typename std::vector<T>::iterator i_; // Iterator pointing to a position within the matrix.
+    T *row_{nullptr}; // Pointer to the first element of the row.
 
   public:
     AccessProxy() = default;
 
-    // Set the iterator to a specific position within the matrix.
-    void set(typename std::vector<T>::iterator i)
+    // Set the proxy to a specific row within the matrix.
+    void set(T *row)
     {
-      i_ = i;
+      row_ = row;
     }
 
     // Access elements in the row represented by this proxy.
@@ -32,29 +39,57 @@ namespace matrix
       {
         throw std::out_of_range("n >= COL");
       }
-      std::advance(i_, n);
-      return *i_;
+      return row_[n];
     }
   };
 
-  // SimpleMatrix: A simple matrix data structure.
-  template <typename T, size_t ROW, size_t COL>
+  // SimpleMatrix: A simple matrix data structure. The Layout policy decides how rows are placed in
+  // memory (see storage.hpp); kernels address row r at data() + r * stride().
+  template <typename T, size_t ROW, size_t COL, class Layout = Dense<>>
   class SimpleMatrix
   {
-    std::vector<T> data_;
+    using storage_type = typename Layout::template storage<T, ROW, COL>;
+
+    storage_type data_;
     AccessProxy<T, COL> proxy_;
 
   public:
+    using value_type = T;
+    using layout_type = Layout;
+
+    // True when rows are stored back to back, so the matrix is one flat ROW * COL sequence.
+    static constexpr bool contiguous = storage_type::stride() == COL;
+
+    // Byte boundary that every row starts on, or 0 when only the first row is aligned.
+    static constexpr size_t row_alignment = storage_type::aligned_rows ? storage_type::alignment : 0;
+
     // Constructor: Initialize the matrix with default-initialized elements.
-    SimpleMatrix() : data_(ROW * COL) {}
+    SimpleMatrix() = default;
 
     // Constructor: Initialize the matrix with elements from an initializer list.
-    explicit SimpleMatrix(std::initializer_list<T> init_list) : data_(init_list)
+    explicit SimpleMatrix(std::initializer_list<T> init_list)
     {
       if (init_list.size() != ROW * COL)
       {
         throw std::invalid_argument("Invalid initializer list size");
       }
+      auto it = init_list.begin();
+      for (size_t i = 0; i < ROW; i++, it += COL)
+      {
+        std::copy(it, it + COL, row(i));
+      }
+    }
+
+    // Constructor: Build the storage from `args`, e.g. the buffer of an External matrix (see view() and adopt()).
+    template <class... Args>
+    explicit SimpleMatrix(std::in_place_t, Args &&...args) : data_(std::forward<Args>(args)...) {}
+
+    // Constructor: Copy a matrix of the same shape with another layout.
+    template <class S>
+      requires(!std::is_same_v<S, Layout>)
+    explicit SimpleMatrix(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+      *this = m;
     }
 
     // Copy constructor.
@@ -69,10 +104,57 @@ namespace matrix
     // Move assignment operator.
     SimpleMatrix &operator=(SimpleMatrix &&m) noexcept = default;
 
+    // Assignment from a matrix of the same shape with another layout: copies the elements into this
+    // matrix's storage, e.g. writing a result into an external buffer.
+    template <class S>
+      requires(!std::is_same_v<S, Layout>)
+    SimpleMatrix &operator=(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+      for (size_t i = 0; i < ROW; i++)
+      {
+        std::copy(m.row(i), m.row(i) + COL, row(i));
+      }
+      return *this;
+    }
+
     // Access an element at a specific row and column.
     constexpr T const &at(size_t const r, size_t const c) const
     {
-      return data_.at(r * COL + c);
+      if (r >= ROW || c >= COL)
+      {
+        throw std::out_of_range("r >= ROW || c >= COL");
+      }
+      return data()[r * stride() + c];
+    }
+
+    // Distance in elements between the starts of consecutive rows.
+    static constexpr size_t stride()
+    {
+      return storage_type::stride();
+    }
+
+    // Pointer to the first element of the row-major storage.
+    T *data()
+    {
+      return data_.data();
+    }
+
+    // Constant pointer to the first element of the row-major storage.
+    const T *data() const
+    {
+      return data_.data();
+    }
+
+    // Pointer to the first element of row r (unchecked).
+    T *row(size_t const r)
+    {
+      return data() + r * stride();
+    }
+
+    // Constant pointer to the first element of row r (unchecked).
+    const T *row(size_t const r) const
+    {
+      return data() + r * stride();
     }
 
     // Access a row using the [] operator and return an AccessProxy.
@@ -83,53 +165,103 @@ namespace matrix
         throw std::out_of_range("r >= ROW");
       }
 
-      auto it = data_.begin();
-      std::advance(it, r * COL);
-      proxy_.set(it);
+      proxy_.set(row(r));
       return proxy_;
     }
 
-    // Addition operator for matrix addition.
-    friend SimpleMatrix operator+(SimpleMatrix lhs, const SimpleMatrix &rhs)
+    // Equality operator: matrices of the same shape compare element-wise.
+    friend bool operator==(const SimpleMatrix &lhs, const SimpleMatrix &rhs)
     {
-      for (size_t i = 0; i < ROW * COL; i++)
+      for (size_t i = 0; i < ROW; i++)
       {
-        lhs.data_[i] += rhs.data_[i];
+        if (!std::equal(lhs.row(i), lhs.row(i) + COL, rhs.row(i)))
+        {
+          return false;
+        }
       }
-      return lhs;
+      return true;
+    }
+
+    // In-place addition of a matrix of the same shape; never allocates.
+    template <class S>
+    SimpleMatrix &operator+=(const SimpleMatrix<T, ROW, COL, S> &rhs)
+    {
+      for (size_t i = 0; i < ROW; i++)
+      {
+        T *l = row(i);
+        const T *r = rhs.row(i);
+        if constexpr (is_compact_float_v<T>)
+        {
+          detail::compact_add(l, r, l, COL);
+        }
+        else
+        {
+          for (size_t j = 0; j < COL; j++)
+          {
+            l[j] += r[j];
+          }
+        }
+      }
+      return *this;
+    }
+
+    // In-place scalar multiplication; never allocates.
+    SimpleMatrix &operator*=(const T n)
+    {
+      for (size_t i = 0; i < ROW; i++)
+      {
+        std::ranges::transform(row(i), row(i) + COL, row(i),
+                               [&n](auto &el)
+                               { return el * n; });
+      }
+      return *this;
+    }
+
+    // Addition operator for matrix addition.
+    // Operands are taken by reference: a by-value parameter would copy any operand whose storage is not shared (COW).
+    friend SimpleMatrix<T, ROW, COL, result_layout_t<Layout>> operator+(const SimpleMatrix &lhs, const SimpleMatrix &rhs)
+    {
+      MATRIX_INSTRUMENT_SCOPE("add", ROW, COL, 0, ROW * COL, 3 * ROW * COL * sizeof(T));
+      SimpleMatrix<T, ROW, COL, result_layout_t<Layout>> result(lhs);
+      result += rhs;
+      return result; // Returning the reference from += would copy instead of move.
     }
 
     // Scalar multiplication operator.
-    friend SimpleMatrix operator*(SimpleMatrix lhs, const T n)
+    friend SimpleMatrix<T, ROW, COL, result_layout_t<Layout>> operator*(const SimpleMatrix &lhs, const T n)
     {
-      std::ranges::transform(lhs.data_.begin(), lhs.data_.end(), lhs.data_.begin(),
-                             [&n](auto &el)
-                             { return el * n; });
-      return lhs;
+      MATRIX_INSTRUMENT_SCOPE("scale", ROW, COL, 0, ROW * COL, 2 * ROW * COL * sizeof(T));
+      SimpleMatrix<T, ROW, COL, result_layout_t<Layout>> result(lhs);
+      result *= n;
+      return result;
     }
 
     // Constant iterator for the beginning of the matrix.
     auto cbegin() const
+      requires contiguous
     {
-      return data_.cbegin();
+      return data();
     }
 
     // Constant iterator for the end of the matrix.
     auto cend() const
+      requires contiguous
     {
-      return data_.cend();
+      return data() + ROW * COL;
     }
 
     // Iterator for the beginning of the matrix.
     auto begin()
+      requires contiguous
     {
-      return data_.begin();
+      return data();
     }
 
     // Iterator for the end of the matrix.
     auto end()
+      requires contiguous
     {
-      return data_.end();
+      return data() + ROW * COL;
     }
 
     // Output operator to display the matrix.
@@ -139,7 +271,7 @@ namespace matrix
       {
         for (size_t j = 0; j < COL; j++)
         {
-          os << std::setw(3) << m.data_[i * COL + j] << " ";
+          os << std::setw(3) << m.row(i)[j] << " ";
         }
         os << "\n";
       }
@@ -149,9 +281,12 @@ namespace matrix
     // Input operator to read values into the matrix.
     friend std::istream &operator>>(std::istream &is, SimpleMatrix &m)
     {
-      for (size_t i = 0; i < ROW * COL; i++)
+      for (size_t i = 0; i < ROW; i++)
       {
-        is >> m.data_[i];
+        for (size_t j = 0; j < COL; j++)
+        {
+          is >> m.row(i)[j];
+        }
       }
       return is;
     }
@@ -164,4 +299,51 @@ namespace matrix
     }
   }; // SimpleMatrix
 
+  // Matrix whose rows start on cache-line boundaries with a stride chosen to avoid cache-set aliasing.
+  template <typename T, size_t ROW, size_t COL, size_t ALIGN = default_alignment>
+  using PaddedMatrix = SimpleMatrix<T, ROW, COL, Padded<ALIGN>>;
+
+  // Matrix whose copies share one buffer until either is modified.
+  template <typename T, size_t ROW, size_t COL, size_t ALIGN = default_alignment>
+  using SharedMatrix = SimpleMatrix<T, ROW, COL, Shared<ALIGN>>;
+
+  // Matrix in a buffer owned outside the library, with rows STRIDE elements apart (0 meaning COL).
+  template <typename T, size_t ROW, size_t COL, size_t STRIDE = 0>
+  using ExternalMatrix = SimpleMatrix<T, ROW, COL, External<STRIDE>>;
+
+  // View `data` as a ROW x COL matrix without copying it. The buffer must outlive the matrix and hold
+  // (ROW - 1) * STRIDE + COL elements; copies of the matrix are owned copies.
+  template <size_t ROW, size_t COL, size_t STRIDE = 0, class T>
+  ExternalMatrix<T, ROW, COL, STRIDE> view(T *data)
+  {
+    if (data == nullptr)
+    {
+      throw std::invalid_argument("data == nullptr");
+    }
+    return ExternalMatrix<T, ROW, COL, STRIDE>(std::in_place, data);
+  }
+
+  // View a span as a ROW x COL matrix; throws std::invalid_argument when it is too small.
+  template <size_t ROW, size_t COL, size_t STRIDE = 0, class T, size_t EXTENT>
+  ExternalMatrix<T, ROW, COL, STRIDE> view(std::span<T, EXTENT> data)
+  {
+    if (data.size() < External<STRIDE>::template storage<T, ROW, COL>::extent)
+    {
+      throw std::invalid_argument("Buffer is smaller than the matrix");
+    }
+    return view<ROW, COL, STRIDE>(data.data());
+  }
+
+  // Take ownership of `data` as a ROW x COL matrix without copying it; release(data) is called when the
+  // matrix is destroyed.
+  template <size_t ROW, size_t COL, size_t STRIDE = 0, class T, class Release>
+  ExternalMatrix<T, ROW, COL, STRIDE> adopt(T *data, Release release)
+  {
+    if (data == nullptr)
+    {
+      throw std::invalid_argument("data == nullptr");
+    }
+    return ExternalMatrix<T, ROW, COL, STRIDE>(std::in_place, data, std::function<void(T *)>(std::move(release)));
+  }
+
 } // namespace matrix
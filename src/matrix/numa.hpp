@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace matrix
+{
+
+    // Allocations of at least this many bytes get the NUMA policy. It covers the whole pages inside the
+    // allocation; the partial pages at either end may be shared with neighbouring allocations and stay
+    // with first touch. (Page-aligning the allocations instead would make malloc map fresh pages for each.)
+    inline constexpr size_t numa_allocation_bytes = size_t{1} << 20;
+
+    // NumaMode: Where the pages of large allocations are placed.
+    enum class NumaMode
+    {
+        FirstTouch, // On the node of the thread that first writes each page (the kernel default).
+        Interleave, // Round-robin across the nodes, for data every thread reads.
+        Bind,       // Only on the given nodes.
+        Preferred,  // On the lowest given node while it has free memory.
+    };
+
+    // NumaPolicy: Placement of large allocations; `nodes` is a bit mask of nodes, 0 meaning all of them.
+    struct NumaPolicy
+    {
+        NumaMode mode{NumaMode::FirstTouch};
+        uint64_t nodes{0};
+    };
+
+    namespace detail
+    {
+
+        // Parse a sysfs CPU list such as "0-3,8,10-11".
+        inline std::vector<unsigned> parse_cpu_list(const std::string &list)
+        {
+            std::vector<unsigned> cpus;
+            size_t pos{0};
+            while (pos < list.size())
+            {
+                size_t const end = std::min(list.find(',', pos), list.size());
+                std::string const range = list.substr(pos, end - pos);
+                size_t const dash = range.find('-');
+                if (!range.empty() && range.find_first_not_of("0123456789-\n") == std::string::npos)
+                {
+                    unsigned const lo = unsigned(std::stoul(range));
+                    unsigned const hi = dash == std::string::npos ? lo : unsigned(std::stoul(range.substr(dash + 1)));
+                    for (unsigned c = lo; c <= hi; c++)
+                    {
+                        cpus.push_back(c);
+                    }
+                }
+                pos = end + 1;
+            }
+            return cpus;
+        }
+
+        // Topology: CPUs of each node this process may run on, and the mask of nodes that exist.
+        struct Topology
+        {
+            std::vector<std::vector<unsigned>> cpus;
+            uint64_t nodes{0};
+        };
+
+        inline Topology read_topology()
+        {
+            Topology topology;
+            auto &nodes = topology.cpus;
+#if defined(__linux__)
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            bool const masked = ::sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+            for (unsigned node{0}; node < 64; node++)
+            {
+                std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string list;
+                if (!in || !std::getline(in, list))
+                {
+                    continue;
+                }
+                nodes.resize(node + 1);
+                topology.nodes |= uint64_t{1} << node;
+                for (unsigned cpu : parse_cpu_list(list))
+                {
+                    if (!masked || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)))
+                    {
+                        nodes[node].push_back(cpu);
+                    }
+                }
+            }
+#endif
+            return topology;
+        }
+
+        inline const Topology &topology()
+        {
+            static Topology const t = read_topology();
+            return t;
+        }
+
+        struct PolicyState
+        {
+            std::mutex mutex;
+            NumaPolicy policy;
+            bool used{false}; // A policy other than FirstTouch was set at some point.
+        };
+
+        inline PolicyState &policy_state()
+        {
+            static PolicyState state;
+            return state;
+        }
+
+        inline size_t page_bytes()
+        {
+#if defined(__linux__)
+            static size_t const page = size_t(::sysconf(_SC_PAGESIZE));
+            return page;
+#else
+            return 4096;
+#endif
+        }
+
+#if defined(__linux__)
+        // Set the policy of the whole pages inside [p, p + bytes).
+        inline void mbind(void *p, size_t const bytes, int const mode, uint64_t const nodes)
+        {
+            size_t const page = page_bytes();
+            uintptr_t const begin = (reinterpret_cast<uintptr_t>(p) + page - 1) / page * page;
+            uintptr_t const end = (reinterpret_cast<uintptr_t>(p) + bytes) / page * page;
+            if (end <= begin)
+            {
+                return;
+            }
+            unsigned long mask = (unsigned long)nodes;
+            // Best effort: a refused policy leaves the pages to first touch.
+            (void)::syscall(SYS_mbind, begin, end - begin, mode, mode == MPOL_DEFAULT ? nullptr : &mask,
+                            mode == MPOL_DEFAULT ? 0 : 8 * sizeof(mask), MPOL_MF_MOVE);
+        }
+#endif
+
+        // Apply the current policy to a fresh allocation.
+        inline void apply_numa_policy(void *p, size_t const bytes)
+        {
+#if defined(__linux__)
+            NumaPolicy policy;
+            {
+                auto &s = policy_state();
+                std::lock_guard lock(s.mutex);
+                if (!s.used)
+                {
+                    return;
+                }
+                policy = s.policy;
+            }
+            uint64_t const nodes = policy.nodes != 0 ? policy.nodes : topology().nodes;
+            switch (policy.mode)
+            {
+            case NumaMode::FirstTouch:
+                mbind(p, bytes, MPOL_DEFAULT, 0);
+                break;
+            case NumaMode::Interleave:
+                mbind(p, bytes, MPOL_INTERLEAVE, nodes);
+                break;
+            case NumaMode::Bind:
+                mbind(p, bytes, MPOL_BIND, nodes);
+                break;
+            case NumaMode::Preferred:
+                mbind(p, bytes, MPOL_PREFERRED, nodes & (~nodes + 1));
+                break;
+            }
+#else
+            (void)p;
+            (void)bytes;
+#endif
+        }
+
+        // Drop the policy of an allocation before its memory returns to the heap.
+        inline void release_numa_policy(void *p, size_t const bytes)
+        {
+#if defined(__linux__)
+            auto &s = policy_state();
+            std::lock_guard lock(s.mutex);
+            if (s.used)
+            {
+                mbind(p, bytes, MPOL_DEFAULT, 0);
+            }
+#else
+            (void)p;
+            (void)bytes;
+#endif
+        }
+
+        // Pin the calling thread to one CPU. Returns false when the system refuses.
+        inline bool pin_current_thread(unsigned const cpu)
+        {
+#if defined(__linux__)
+            if (cpu >= CPU_SETSIZE)
+            {
+                return false;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+            (void)cpu;
+            return false;
+#endif
+        }
+
+    } // namespace detail
+
+    // CPUs of each NUMA node that this process may run on; empty when the topology is unknown.
+    inline const std::vector<std::vector<unsigned>> &numa_nodes()
+    {
+        return detail::topology().cpus;
+    }
+
+    // CPUs in node order: thread t of a pinned ThreadPool runs on entry t (modulo the count), so the
+    // row blocks of consecutive threads, and the pages they first touch, stay on one node.
+    inline const std::vector<unsigned> &numa_cpu_order()
+    {
+        static std::vector<unsigned> const order = []
+        {
+            std::vector<unsigned> cpus;
+            for (auto const &node : numa_nodes())
+            {
+                cpus.insert(cpus.end(), node.begin(), node.end());
+            }
+            return cpus;
+        }();
+        return order;
+    }
+
+    // Node holding the page at `p`, or -1 when unknown or not yet touched.
+    inline int numa_node_of(const void *p)
+    {
+#if defined(__linux__)
+        int node{-1};
+        if (::syscall(SYS_get_mempolicy, &node, nullptr, 0, p, MPOL_F_NODE | MPOL_F_ADDR) == 0)
+        {
+            return node;
+        }
+#else
+        (void)p;
+#endif
+        return -1;
+    }
+
+    // Current policy for allocations of at least numa_allocation_bytes.
+    inline NumaPolicy numa_policy()
+    {
+        auto &s = detail::policy_state();
+        std::lock_guard lock(s.mutex);
+        return s.policy;
+    }
+
+    // Set the policy for allocations made from now on and return the previous one. Existing matrices
+    // keep their placement.
+    inline NumaPolicy set_numa_policy(NumaPolicy const policy)
+    {
+        auto &s = detail::policy_state();
+        std::lock_guard lock(s.mutex);
+        s.used = s.used || policy.mode != NumaMode::FirstTouch;
+        return std::exchange(s.policy, policy);
+    }
+
+} // namespace matrix
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX__) || defined(__F16C__)
+// GCC 12 flags the `_mm*_undefined_*()` placeholders inside the AVX-512 intrinsics as uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+namespace matrix
+{
+
+    // half: IEEE 754 binary16 storage type. Arithmetic happens in float; values are rounded to nearest-even on store.
+    class half
+    {
+        uint16_t bits_{0};
+
+    public:
+        half() = default;
+
+        half(float const f) : bits_(from_float(f)) {}
+
+        operator float() const
+        {
+            return to_float(bits_);
+        }
+
+        // Raw binary16 encoding.
+        uint16_t bits() const
+        {
+            return bits_;
+        }
+
+        static half from_bits(uint16_t const bits)
+        {
+            half h;
+            h.bits_ = bits;
+            return h;
+        }
+
+        half &operator+=(float const x)
+        {
+            return *this = float(*this) + x;
+        }
+
+        half &operator-=(float const x)
+        {
+            return *this = float(*this) - x;
+        }
+
+        half &operator*=(float const x)
+        {
+            return *this = float(*this) * x;
+        }
+
+        half &operator/=(float const x)
+        {
+            return *this = float(*this) / x;
+        }
+
+        // Convert float to binary16 bits, rounding to nearest-even.
+        static constexpr uint16_t from_float(float const f)
+        {
+            uint32_t const x = std::bit_cast<uint32_t>(f);
+            uint16_t const sign = (x >> 16) & 0x8000;
+            uint32_t const a = x & 0x7fffffff;
+
+            if (a > 0x7f800000) // NaN stays a quiet NaN.
+            {
+                return sign | 0x7e00;
+            }
+            if (a >= 0x47800000) // |f| >= 65536 and infinities.
+            {
+                return sign | 0x7c00;
+            }
+            if (a < 0x38800000) // Below the smallest normal half: subnormal or zero.
+            {
+                if (a < 0x33000000)
+                {
+                    return sign;
+                }
+                uint32_t const shift = 126 - (a >> 23);
+                uint32_t const m = (a & 0x7fffff) | 0x800000;
+                uint32_t q = m >> shift;
+                uint32_t const rem = m & ((1u << shift) - 1);
+                uint32_t const halfway = 1u << (shift - 1);
+                if (rem > halfway || (rem == halfway && (q & 1)))
+                {
+                    q++;
+                }
+                return sign | q;
+            }
+
+            uint32_t h = (a - 0x38000000) >> 13;
+            uint32_t const rem = a & 0x1fff;
+            if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+            {
+                h++; // May carry into the exponent, up to infinity.
+            }
+            return sign | h;
+        }
+
+        // Convert binary16 bits to float (exact).
+        static constexpr float to_float(uint16_t const h)
+        {
+            uint32_t const sign = uint32_t(h & 0x8000) << 16;
+            uint32_t e = (h >> 10) & 0x1f;
+            uint32_t m = h & 0x3ff;
+
+            if (e == 0x1f)
+            {
+                return std::bit_cast<float>(sign | 0x7f800000 | (m << 13));
+            }
+            if (e != 0)
+            {
+                return std::bit_cast<float>(sign | ((e + 112) << 23) | (m << 13));
+            }
+            if (m == 0)
+            {
+                return std::bit_cast<float>(sign);
+            }
+
+            e = 113;
+            while (!(m & 0x400))
+            {
+                m <<= 1;
+                e--;
+            }
+            return std::bit_cast<float>(sign | (e << 23) | ((m & 0x3ff) << 13));
+        }
+    }; // half
+
+    // bfloat16: The upper 16 bits of an IEEE float. Same range as float with an 8-bit significand.
+    class bfloat16
+    {
+        uint16_t bits_{0};
+
+    public:
+        bfloat16() = default;
+
+        bfloat16(float const f) : bits_(from_float(f)) {}
+
+        operator float() const
+        {
+            return to_float(bits_);
+        }
+
+        // Raw bfloat16 encoding.
+        uint16_t bits() const
+        {
+            return bits_;
+        }
+
+        static bfloat16 from_bits(uint16_t const bits)
+        {
+            bfloat16 b;
+            b.bits_ = bits;
+            return b;
+        }
+
+        bfloat16 &operator+=(float const x)
+        {
+            return *this = float(*this) + x;
+        }
+
+        bfloat16 &operator-=(float const x)
+        {
+            return *this = float(*this) - x;
+        }
+
+        bfloat16 &operator*=(float const x)
+        {
+            return *this = float(*this) * x;
+        }
+
+        bfloat16 &operator/=(float const x)
+        {
+            return *this = float(*this) / x;
+        }
+
+        // Convert float to bfloat16 bits, rounding to nearest-even.
+        static constexpr uint16_t from_float(float const f)
+        {
+            uint32_t const x = std::bit_cast<uint32_t>(f);
+            if ((x & 0x7fffffff) > 0x7f800000)
+            {
+                return uint16_t((x >> 16) | 0x40);
+            }
+            return uint16_t((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+        }
+
+        // Convert bfloat16 bits to float (exact).
+        static constexpr float to_float(uint16_t const b)
+        {
+            return std::bit_cast<float>(uint32_t(b) << 16);
+        }
+    }; // bfloat16
+
+    // True for the 2-byte floating-point storage types that compute in float.
+    template <class T>
+    inline constexpr bool is_compact_float_v = std::is_same_v<T, half> || std::is_same_v<T, bfloat16>;
+
+    // accumulator: Type that sums and products of T are accumulated in.
+    template <class T>
+    struct accumulator
+    {
+        using type = T;
+    };
+
+    template <>
+    struct accumulator<half>
+    {
+        using type = float;
+    };
+
+    template <>
+    struct accumulator<bfloat16>
+    {
+        using type = float;
+    };
+
+    template <>
+    struct accumulator<int8_t>
+    {
+        using type = int32_t;
+    };
+
+    template <>
+    struct accumulator<int16_t>
+    {
+        using type = int64_t;
+    };
+
+    template <>
+    struct accumulator<int32_t>
+    {
+        using type = int64_t;
+    };
+
+    template <class T>
+    using accumulator_t = typename accumulator<T>::type;
+
+    namespace detail
+    {
+
+        // Number of elements converted per step by the blocked compact-type kernels.
+        inline constexpr size_t convert_block = 256;
+
+        // Widen n binary16 values to float.
+        inline void widen(const half *src, float *dst, size_t const n)
+        {
+            size_t i{0};
+            auto const *s = reinterpret_cast<const uint16_t *>(src);
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+            {
+                _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i))));
+            }
+#endif
+#if defined(__F16C__)
+            for (; i + 8 <= n; i += 8)
+            {
+                _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i))));
+            }
+#endif
+            for (; i < n; i++)
+            {
+                dst[i] = half::to_float(s[i]);
+            }
+        }
+
+        // Narrow n floats to binary16 with round-to-nearest-even.
+        inline void narrow(const float *src, half *dst, size_t const n)
+        {
+            size_t i{0};
+            auto *d = reinterpret_cast<uint16_t *>(dst);
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + i),
+                                    _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+            }
+#endif
+#if defined(__F16C__)
+            for (; i + 8 <= n; i += 8)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i),
+                                 _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+            }
+#endif
+            for (; i < n; i++)
+            {
+                d[i] = half::from_float(src[i]);
+            }
+        }
+
+        // Widen n bfloat16 values to float.
+        inline void widen(const bfloat16 *src, float *dst, size_t const n)
+        {
+            size_t i{0};
+            auto const *s = reinterpret_cast<const uint16_t *>(src);
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+            {
+                __m512i const w = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i)));
+                _mm512_storeu_ps(dst + i, _mm512_castsi512_ps(_mm512_slli_epi32(w, 16)));
+            }
+#endif
+#if defined(__AVX2__)
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256i const w = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i)));
+                _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(w, 16)));
+            }
+#endif
+            for (; i < n; i++)
+            {
+                dst[i] = bfloat16::to_float(s[i]);
+            }
+        }
+
+        // Narrow n floats to bfloat16 with round-to-nearest-even. The vector path uses the same integer
+        // rounding as the scalar one, so results do not depend on the instruction set.
+        inline void narrow(const float *src, bfloat16 *dst, size_t const n)
+        {
+            size_t i{0};
+            auto *d = reinterpret_cast<uint16_t *>(dst);
+#if defined(__AVX2__)
+            __m256i const bias = _mm256_set1_epi32(0x7fff);
+            __m256i const one = _mm256_set1_epi32(1);
+            __m256i const abs_mask = _mm256_set1_epi32(0x7fffffff);
+            __m256i const inf = _mm256_set1_epi32(0x7f800000);
+            __m256i const quiet = _mm256_set1_epi32(0x400000);
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256i const x = _mm256_castps_si256(_mm256_loadu_ps(src + i));
+                __m256i const lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+                __m256i r = _mm256_add_epi32(x, _mm256_add_epi32(bias, lsb));
+                __m256i const nan = _mm256_cmpgt_epi32(_mm256_and_si256(x, abs_mask), inf);
+                r = _mm256_blendv_epi8(r, _mm256_or_si256(x, quiet), nan);
+                r = _mm256_srli_epi32(r, 16);
+                __m128i const packed = _mm_packus_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), packed);
+            }
+#endif
+            for (; i < n; i++)
+            {
+                d[i] = bfloat16::from_float(src[i]);
+            }
+        }
+
+        // dst = a + b for compact types: both operands are widened block by block and the sum rounded once.
+        template <class T>
+        void compact_add(const T *a, const T *b, T *dst, size_t const n)
+        {
+            float wa[convert_block];
+            float wb[convert_block];
+            for (size_t i{0}; i < n; i += convert_block)
+            {
+                size_t const len = std::min(convert_block, n - i);
+                widen(a + i, wa, len);
+                widen(b + i, wb, len);
+                for (size_t k{0}; k < len; k++)
+                {
+                    wa[k] += wb[k];
+                }
+                narrow(wa, dst + i, len);
+            }
+        }
+
+    } // namespace detail
+
+} // namespace matrix
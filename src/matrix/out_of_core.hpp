@@ -0,0 +1,522 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix.hpp"
+
+namespace matrix
+{
+
+    // Default edge of the square tiles of a FileMatrix.
+    inline constexpr size_t default_file_tile = 1024;
+
+    // How a FileMatrix treats its file.
+    enum class FileMode
+    {
+        Create, // Create or truncate the file and fill it with zeros.
+        Open    // Open an existing file whose size must match the shape.
+    };
+
+    // FileMatrix: A rows x cols matrix kept in a file as square tiles. Tiles are stored row-major, each
+    // tile row-major and full-sized, so edge tiles are zero padded and every tile is one contiguous
+    // read or write at a fixed offset.
+    template <typename T>
+    class FileMatrix
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "File matrices hold trivially copyable elements.");
+
+        int fd_{-1};
+        size_t rows_{0};
+        size_t cols_{0};
+        size_t tile_{0};
+
+        [[noreturn]] static void fail(const char *what)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+    public:
+        using value_type = T;
+
+        // Constructor: Create or open the file at path for a rows x cols matrix with tile x tile tiles.
+        FileMatrix(const std::string &path, size_t const rows, size_t const cols, size_t const tile = default_file_tile,
+                   FileMode const mode = FileMode::Create)
+            : rows_(rows), cols_(cols), tile_(tile)
+        {
+            if (rows == 0 || cols == 0 || tile == 0)
+            {
+                throw std::invalid_argument("File matrix dimensions and tile size must be positive");
+            }
+            fd_ = ::open(path.c_str(), mode == FileMode::Create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+            if (fd_ < 0)
+            {
+                fail("open");
+            }
+            off_t const bytes = off_t(file_bytes());
+            if (mode == FileMode::Create)
+            {
+                if (::ftruncate(fd_, bytes) != 0)
+                {
+                    ::close(fd_);
+                    fail("ftruncate");
+                }
+            }
+            else
+            {
+                struct stat st;
+                if (::fstat(fd_, &st) != 0 || st.st_size != bytes)
+                {
+                    ::close(fd_);
+                    throw std::invalid_argument("File size does not match the matrix shape");
+                }
+            }
+        }
+
+        FileMatrix(const FileMatrix &) = delete;
+        FileMatrix &operator=(const FileMatrix &) = delete;
+
+        // Move constructor.
+        FileMatrix(FileMatrix &&m) noexcept
+            : fd_(std::exchange(m.fd_, -1)), rows_(m.rows_), cols_(m.cols_), tile_(m.tile_) {}
+
+        // Move assignment operator.
+        FileMatrix &operator=(FileMatrix &&m) noexcept
+        {
+            std::swap(fd_, m.fd_);
+            rows_ = m.rows_;
+            cols_ = m.cols_;
+            tile_ = m.tile_;
+            return *this;
+        }
+
+        ~FileMatrix()
+        {
+            if (fd_ >= 0)
+            {
+                ::close(fd_);
+            }
+        }
+
+        size_t rows() const
+        {
+            return rows_;
+        }
+
+        size_t cols() const
+        {
+            return cols_;
+        }
+
+        size_t tile() const
+        {
+            return tile_;
+        }
+
+        // Number of tiles down and across the matrix.
+        size_t tile_rows() const
+        {
+            return (rows_ + tile_ - 1) / tile_;
+        }
+
+        size_t tile_cols() const
+        {
+            return (cols_ + tile_ - 1) / tile_;
+        }
+
+        // Elements in one tile, padding included.
+        size_t tile_elements() const
+        {
+            return tile_ * tile_;
+        }
+
+        size_t file_bytes() const
+        {
+            return tile_rows() * tile_cols() * tile_elements() * sizeof(T);
+        }
+
+        // Read tile (ti, tj) into dst, which holds tile_elements() values.
+        void read_tile(size_t const ti, size_t const tj, T *dst) const
+        {
+            auto *p = reinterpret_cast<char *>(dst);
+            size_t left = tile_elements() * sizeof(T);
+            off_t offset = tile_offset(ti, tj);
+            while (left > 0)
+            {
+                ssize_t const n = ::pread(fd_, p, left, offset);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    fail("pread");
+                }
+                p += n;
+                left -= size_t(n);
+                offset += n;
+            }
+        }
+
+        // Write tile (ti, tj) from src, which holds tile_elements() values.
+        void write_tile(size_t const ti, size_t const tj, const T *src)
+        {
+            auto *p = reinterpret_cast<const char *>(src);
+            size_t left = tile_elements() * sizeof(T);
+            off_t offset = tile_offset(ti, tj);
+            while (left > 0)
+            {
+                ssize_t const n = ::pwrite(fd_, p, left, offset);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    fail("pwrite");
+                }
+                p += n;
+                left -= size_t(n);
+                offset += n;
+            }
+        }
+
+        // Ask the kernel to start reading tile (ti, tj) into the page cache. Purely a hint.
+        void advise_tile(size_t const ti, size_t const tj) const
+        {
+#if defined(POSIX_FADV_WILLNEED)
+            ::posix_fadvise(fd_, tile_offset(ti, tj), off_t(tile_elements() * sizeof(T)), POSIX_FADV_WILLNEED);
+#endif
+        }
+
+        // Copy an in-memory matrix of the same shape into the file.
+        template <size_t ROW, size_t COL, class S>
+        void store(const SimpleMatrix<T, ROW, COL, S> &m)
+        {
+            check_shape(ROW, COL);
+            std::vector<T> buffer(tile_elements());
+            for (size_t ti{0}; ti < tile_rows(); ti++)
+            {
+                for (size_t tj{0}; tj < tile_cols(); tj++)
+                {
+                    std::fill(buffer.begin(), buffer.end(), T{});
+                    size_t const r1 = std::min(ROW, (ti + 1) * tile_);
+                    size_t const c0 = tj * tile_;
+                    size_t const c1 = std::min(COL, c0 + tile_);
+                    for (size_t r{ti * tile_}; r < r1; r++)
+                    {
+                        std::copy(m.row(r) + c0, m.row(r) + c1, buffer.data() + (r - ti * tile_) * tile_);
+                    }
+                    write_tile(ti, tj, buffer.data());
+                }
+            }
+        }
+
+        // Read the whole file into an in-memory matrix of the same shape.
+        template <size_t ROW, size_t COL>
+        SimpleMatrix<T, ROW, COL> load() const
+        {
+            check_shape(ROW, COL);
+            SimpleMatrix<T, ROW, COL> result;
+            std::vector<T> buffer(tile_elements());
+            for (size_t ti{0}; ti < tile_rows(); ti++)
+            {
+                for (size_t tj{0}; tj < tile_cols(); tj++)
+                {
+                    read_tile(ti, tj, buffer.data());
+                    size_t const r1 = std::min(ROW, (ti + 1) * tile_);
+                    size_t const c0 = tj * tile_;
+                    size_t const c1 = std::min(COL, c0 + tile_);
+                    for (size_t r{ti * tile_}; r < r1; r++)
+                    {
+                        const T *src = buffer.data() + (r - ti * tile_) * tile_;
+                        std::copy(src, src + (c1 - c0), result.row(r) + c0);
+                    }
+                }
+            }
+            return result;
+        }
+
+    private:
+        off_t tile_offset(size_t const ti, size_t const tj) const
+        {
+            if (ti >= tile_rows() || tj >= tile_cols())
+            {
+                throw std::out_of_range("ti >= tile_rows() || tj >= tile_cols()");
+            }
+            return off_t((ti * tile_cols() + tj) * tile_elements() * sizeof(T));
+        }
+
+        void check_shape(size_t const rows, size_t const cols) const
+        {
+            if (rows != rows_ || cols != cols_)
+            {
+                throw std::invalid_argument("Matrix shape does not match the file");
+            }
+        }
+    }; // FileMatrix
+
+    // Tile schedule of an out-of-core multiply: C is produced in blocks of block_rows x block_cols tiles.
+    struct OutOfCorePlan
+    {
+        size_t block_rows{0};
+        size_t block_cols{0};
+        size_t bytes{0}; // Memory the schedule keeps resident.
+    };
+
+    namespace detail
+    {
+
+        // IoQueue: One background thread that runs I/O jobs in submission order.
+        class IoQueue
+        {
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::deque<std::packaged_task<void()>> jobs_;
+            bool stop_{false};
+            std::thread thread_; // Started last, after the state it uses.
+
+            void work()
+            {
+                for (;;)
+                {
+                    std::packaged_task<void()> job;
+                    {
+                        std::unique_lock lock(mutex_);
+                        wake_.wait(lock, [&]
+                                   { return stop_ || !jobs_.empty(); });
+                        if (jobs_.empty())
+                        {
+                            return;
+                        }
+                        job = std::move(jobs_.front());
+                        jobs_.pop_front();
+                    }
+                    job();
+                }
+            }
+
+        public:
+            IoQueue() : thread_([this]
+                                { work(); }) {}
+
+            // Finishes the queued jobs before returning.
+            ~IoQueue()
+            {
+                {
+                    std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                wake_.notify_all();
+                thread_.join();
+            }
+
+            std::future<void> submit(std::function<void()> f)
+            {
+                std::packaged_task<void()> job(std::move(f));
+                auto done = job.get_future();
+                {
+                    std::lock_guard lock(mutex_);
+                    jobs_.push_back(std::move(job));
+                }
+                wake_.notify_one();
+                return done;
+            }
+        };
+
+        // Bytes resident for a block of bm x bn C tiles: two C blocks (one computing, one being written
+        // back) and two A/B panels (one computing, one being prefetched).
+        inline size_t out_of_core_bytes(size_t const tile_bytes, size_t const bm, size_t const bn)
+        {
+            return tile_bytes * (2 * bm * bn + 2 * (bm + bn));
+        }
+
+    } // namespace detail
+
+    // Pick the largest, roughly square C block whose working set fits in memory_budget bytes.
+    template <class T>
+    OutOfCorePlan plan_out_of_core(const FileMatrix<T> &a, const FileMatrix<T> &b, size_t const memory_budget)
+    {
+        size_t const tile_bytes = a.tile_elements() * sizeof(T);
+        if (detail::out_of_core_bytes(tile_bytes, 1, 1) > memory_budget)
+        {
+            throw std::invalid_argument("Memory budget is smaller than six tiles");
+        }
+
+        OutOfCorePlan plan{1, 1, detail::out_of_core_bytes(tile_bytes, 1, 1)};
+        for (bool grew = true; grew;)
+        {
+            grew = false;
+            if (plan.block_rows < a.tile_rows() && plan.block_rows <= plan.block_cols &&
+                detail::out_of_core_bytes(tile_bytes, plan.block_rows + 1, plan.block_cols) <= memory_budget)
+            {
+                plan.block_rows++;
+                grew = true;
+            }
+            if (plan.block_cols < b.tile_cols() &&
+                detail::out_of_core_bytes(tile_bytes, plan.block_rows, plan.block_cols + 1) <= memory_budget)
+            {
+                plan.block_cols++;
+                grew = true;
+            }
+        }
+        plan.bytes = detail::out_of_core_bytes(tile_bytes, plan.block_rows, plan.block_cols);
+        return plan;
+    }
+
+    // C = A * B for file-backed matrices within memory_budget bytes. C is produced one block of tiles at
+    // a time; while the block multiplies the current A and B panels, the I/O thread reads the next
+    // panels (the kernel is told about the panels after that) and writes the previous C block back.
+    template <class T>
+    void multiply_out_of_core(const FileMatrix<T> &a, const FileMatrix<T> &b, FileMatrix<T> &c, size_t const memory_budget)
+    {
+        static_assert(std::is_arithmetic_v<T>, "Out-of-core multiply requires an arithmetic element type.");
+        if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols())
+        {
+            throw std::invalid_argument("Matrix dimensions are incompatible for multiplication");
+        }
+        if (a.tile() != b.tile() || a.tile() != c.tile())
+        {
+            throw std::invalid_argument("Out-of-core operands must share one tile size");
+        }
+
+        MATRIX_INSTRUMENT_SCOPE("multiply_out_of_core", a.rows(), b.cols(), a.cols(), 2 * a.rows() * a.cols() * b.cols(),
+                                a.file_bytes() + b.file_bytes() + c.file_bytes());
+
+        OutOfCorePlan const plan = plan_out_of_core(a, b, memory_budget);
+        size_t const t = a.tile();
+        size_t const te = a.tile_elements();
+        size_t const tiles_k = a.tile_cols();
+        size_t const bm = plan.block_rows;
+        size_t const bn = plan.block_cols;
+
+        using Buffer = std::vector<T, AlignedAllocator<T>>;
+        struct Panel
+        {
+            Buffer a;
+            Buffer b;
+        };
+        Panel panels[2]{{Buffer(bm * te), Buffer(bn * te)}, {Buffer(bm * te), Buffer(bn * te)}};
+        Buffer blocks[2]{Buffer(bm * bn * te), Buffer(bm * bn * te)};
+
+        // Steps run block by block, k fastest; step s belongs to block s / tiles_k.
+        size_t const blocks_m = (a.tile_rows() + bm - 1) / bm;
+        size_t const blocks_n = (b.tile_cols() + bn - 1) / bn;
+        size_t const steps = blocks_m * blocks_n * tiles_k;
+        auto tile_ranges = [&](size_t s)
+        {
+            size_t const blk = s / tiles_k;
+            size_t const i0 = blk / blocks_n * bm;
+            size_t const j0 = blk % blocks_n * bn;
+            return std::array<size_t, 5>{i0, std::min(a.tile_rows(), i0 + bm), j0, std::min(b.tile_cols(), j0 + bn), s % tiles_k};
+        };
+        auto load = [&](size_t s, Panel &p)
+        {
+            auto const [i0, i1, j0, j1, k] = tile_ranges(s);
+            for (size_t i{i0}; i < i1; i++)
+            {
+                a.read_tile(i, k, p.a.data() + (i - i0) * te);
+            }
+            for (size_t j{j0}; j < j1; j++)
+            {
+                b.read_tile(k, j, p.b.data() + (j - j0) * te);
+            }
+        };
+        auto advise = [&](size_t s)
+        {
+            auto const [i0, i1, j0, j1, k] = tile_ranges(s);
+            for (size_t i{i0}; i < i1; i++)
+            {
+                a.advise_tile(i, k);
+            }
+            for (size_t j{j0}; j < j1; j++)
+            {
+                b.advise_tile(k, j);
+            }
+        };
+
+        std::future<void> loaded;
+        std::future<void> written[2];
+        detail::IoQueue io; // Declared after the buffers so queued jobs finish before they are freed.
+
+        loaded = io.submit([&]
+                           { load(0, panels[0]); });
+        for (size_t s{0}; s < steps; s++)
+        {
+            auto const [i0, i1, j0, j1, k] = tile_ranges(s);
+            Buffer &block = blocks[(s / tiles_k) % 2];
+            if (k == 0)
+            {
+                if (written[(s / tiles_k) % 2].valid())
+                {
+                    written[(s / tiles_k) % 2].get();
+                }
+                std::fill(block.begin(), block.end(), T{});
+            }
+
+            loaded.get();
+            Panel &p = panels[s % 2];
+            if (s + 1 < steps)
+            {
+                loaded = io.submit([&, next = s + 1]
+                                   { load(next, panels[next % 2]); });
+            }
+            if (s + 2 < steps)
+            {
+                advise(s + 2);
+            }
+
+            for (size_t i{i0}; i < i1; i++)
+            {
+                for (size_t j{j0}; j < j1; j++)
+                {
+                    const T *ta = p.a.data() + (i - i0) * te;
+                    const T *tb = p.b.data() + (j - j0) * te;
+                    T *tc = block.data() + ((i - i0) * bn + (j - j0)) * te;
+                    if (t * sizeof(T) % default_alignment == 0)
+                    {
+                        detail::multiply<default_alignment>(ta, t, tb, t, tc, t, t, t, t);
+                    }
+                    else
+                    {
+                        detail::multiply<0>(ta, t, tb, t, tc, t, t, t, t);
+                    }
+                }
+            }
+
+            if (k + 1 == tiles_k)
+            {
+                written[(s / tiles_k) % 2] = io.submit([&, i0 = i0, i1 = i1, j0 = j0, j1 = j1]
+                                                       {
+                                                           for (size_t i{i0}; i < i1; i++)
+                                                           {
+                                                               for (size_t j{j0}; j < j1; j++)
+                                                               {
+                                                                   c.write_tile(i, j, block.data() + ((i - i0) * bn + (j - j0)) * te);
+                                                               }
+                                                           } });
+            }
+        }
+        for (auto &w : written)
+        {
+            if (w.valid())
+            {
+                w.get();
+            }
+        }
+    }
+
+} // namespace matrix
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "numa.hpp"
+
+// Set MATRIX_PIN_THREADS to 1 to pin the workers of the library thread pool to CPUs in NUMA node order.
+#ifndef MATRIX_PIN_THREADS
+#define MATRIX_PIN_THREADS 0
+#endif
+
+namespace matrix
+{
+
+    // Minimum number of elements a kernel should touch before it is worth splitting across threads.
+    inline constexpr size_t parallel_threshold = 1 << 16;
+
+    // Whether ThreadPool::instance() pins its workers.
+    inline constexpr bool pin_threads = MATRIX_PIN_THREADS != 0;
+
+    namespace detail
+    {
+
+        // True while the calling thread runs work for ThreadPool or TaskScheduler; parallel calls made
+        // from there run serially instead of oversubscribing the cores.
+        inline bool &inside_parallel_region()
+        {
+            thread_local bool flag{false};
+            return flag;
+        }
+
+        // Held by the outside thread whose job runs on ThreadPool or TaskScheduler. The two worker sets
+        // take turns through it, so only one of them is busy at a time and the cores are not oversubscribed.
+        inline std::mutex &admission()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        // Pin worker `self` of a pool or scheduler to CPU `self` of numa_cpu_order() when asked to.
+        inline void pin_worker(size_t const self, bool const pin)
+        {
+            if (pin && !numa_cpu_order().empty())
+            {
+                pin_current_thread(numa_cpu_order()[self % numa_cpu_order().size()]);
+            }
+        }
+
+    } // namespace detail
+
+    // ThreadPool: A fixed set of worker threads that execute indexed tasks for parallel_for.
+    // The indices of a job are split into one contiguous range per thread; each thread works through its
+    // own range first and then helps with the others. Thread t therefore handles the t-th share of every
+    // job's rows, whatever the chunk count, which keeps first-touched pages local (see HeapStorage).
+    class ThreadPool
+    {
+        // Range: Indices [next, end) of one thread's share that are not yet claimed.
+        struct alignas(64) Range
+        {
+            std::atomic<size_t> next{0};
+            size_t end{0};
+        };
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+
+        std::function<void(size_t)> const *task_{nullptr}; // Task of the running job.
+        std::unique_ptr<Range[]> ranges_;                  // Share of each thread, the caller's first.
+        size_t pending_{0};                                // Indices not yet finished.
+        size_t generation_{0};                             // Bumped for every new job.
+        size_t active_{0};                                 // Workers currently inside drain().
+        std::exception_ptr error_;                         // First exception thrown by a task.
+        bool stop_{false};
+
+        // Claim and run indices of the current job until none are left, starting with the share of thread `self`.
+        void drain(size_t const self)
+        {
+            size_t const threads = size();
+            for (size_t k{0}; k < threads; k++)
+            {
+                Range &range = ranges_[(self + k) % threads];
+                for (size_t i = range.next.fetch_add(1); i < range.end; i = range.next.fetch_add(1))
+                {
+                    execute(i);
+                }
+            }
+        }
+
+        void execute(size_t const i)
+        {
+            try
+            {
+                (*task_)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(mutex_);
+                if (!error_)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+
+            std::lock_guard lock(mutex_);
+            if (--pending_ == 0)
+            {
+                done_.notify_all();
+            }
+        }
+
+        void work(size_t const self, bool const pin)
+        {
+            detail::inside_parallel_region() = true;
+            detail::pin_worker(self, pin);
+            size_t seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock lock(mutex_);
+                    wake_.wait(lock, [&]
+                               { return stop_ || generation_ != seen; });
+                    if (stop_)
+                    {
+                        return;
+                    }
+                    seen = generation_;
+                    ++active_;
+                }
+                drain(self);
+
+                std::lock_guard lock(mutex_);
+                if (--active_ == 0)
+                {
+                    done_.notify_all();
+                }
+            }
+        }
+
+    public:
+        // Constructor: Start `threads - 1` workers; the calling thread acts as the first one. With `pin`,
+        // worker t runs only on CPU t of numa_cpu_order(); the calling thread is left where it is.
+        explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency()), bool const pin = pin_threads)
+            : ranges_(new Range[std::max<size_t>(threads, 1)])
+        {
+            for (size_t i{1}; i < threads; i++)
+            {
+                workers_.emplace_back([this, i, pin]
+                                      { work(i, pin); });
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto &w : workers_)
+            {
+                w.join();
+            }
+        }
+
+        // Process-wide pool used by the library kernels.
+        static ThreadPool &instance()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        // Number of threads taking part in a job, including the caller.
+        size_t size() const
+        {
+            return workers_.size() + 1;
+        }
+
+        // Run task(0) ... task(count - 1) across the pool and wait for all of them.
+        // Calls made from inside a task run serially, so nested kernels cannot deadlock.
+        void run(size_t count, std::function<void(size_t)> const &task)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            if (count == 1 || workers_.empty() || detail::inside_parallel_region())
+            {
+                for (size_t i{0}; i < count; i++)
+                {
+                    task(i);
+                }
+                return;
+            }
+
+            std::lock_guard serial(detail::admission()); // One job at a time; concurrent callers queue up here.
+            {
+                // Late workers of the previous job must leave before its state is replaced.
+                std::unique_lock lock(mutex_);
+                done_.wait(lock, [&]
+                           { return active_ == 0; });
+                task_ = &task;
+                size_t const threads = size();
+                for (size_t t{0}; t < threads; t++)
+                {
+                    ranges_[t].next = count * t / threads;
+                    ranges_[t].end = count * (t + 1) / threads;
+                }
+                pending_ = count;
+                error_ = nullptr;
+                ++generation_;
+            }
+            wake_.notify_all();
+
+            detail::inside_parallel_region() = true;
+            drain(0);
+            detail::inside_parallel_region() = false;
+
+            std::unique_lock lock(mutex_);
+            done_.wait(lock, [&]
+                       { return pending_ == 0 && active_ == 0; });
+            task_ = nullptr;
+            if (error_)
+            {
+                std::rethrow_exception(std::exchange(error_, nullptr));
+            }
+        }
+    }; // ThreadPool
+
+    // Split [begin, end) into chunks of at least `grain` indices and call f(lo, hi) on each in parallel.
+    template <class F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F &&f)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        auto &pool = ThreadPool::instance();
+        size_t const n = end - begin;
+        size_t const chunks = std::min(pool.size() * 4, std::max<size_t>(1, n / std::max<size_t>(1, grain)));
+        if (chunks <= 1)
+        {
+            f(begin, end);
+            return;
+        }
+
+        size_t const step = (n + chunks - 1) / chunks;
+        pool.run(chunks, [&](size_t c)
+                 {
+                     size_t const lo = begin + c * step;
+                     size_t const hi = std::min(end, lo + step);
+                     if (lo < hi)
+                     {
+                         f(lo, hi);
+                     } });
+    }
+
+} // namespace matrix
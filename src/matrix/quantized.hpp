@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "matrix.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    namespace detail
+    {
+
+        // VNNI multiplies unsigned by signed bytes, so the int8 kernel biases A by +128 and the
+        // GEMM driver subtracts 128 * sum(B column) afterwards.
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+        inline constexpr bool int8_dot_biased = true;
+#else
+        inline constexpr bool int8_dot_biased = false;
+#endif
+
+        // Longest dot product of full-range T values that cannot overflow accumulator_t<T>: 2^17 - 1
+        // for int8, 2^33 - 1 for int16 and 1 for int32.
+        template <class T>
+        inline constexpr size_t wide_depth = []
+        {
+            using Acc = accumulator_t<T>;
+            if constexpr (std::is_integral_v<T> && std::is_integral_v<Acc>)
+            {
+                uint64_t const low = uint64_t(-int64_t(std::numeric_limits<T>::min()));
+                return size_t(uint64_t(std::numeric_limits<Acc>::max()) / (low * low));
+            }
+            else
+            {
+                return std::numeric_limits<size_t>::max();
+            }
+        }();
+
+        // Bytes of packed B^T that one row panel of the wide GEMM keeps hot in L1.
+        inline constexpr size_t wide_panel_bytes = 1 << 15;
+
+#if defined(__AVX2__)
+        inline int32_t hsum_epi32(__m256i const v)
+        {
+            __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+            return _mm_cvtsi128_si32(s);
+        }
+
+        inline int64_t hsum_epi64(__m256i const v)
+        {
+            __m128i const s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+        }
+#endif
+
+        // Exact int8 dot product accumulated in int32 (biased by 128 * sum(b) when int8_dot_biased).
+        // vpmaddubsw is not used: its int16 pair sums saturate for full-range int8 operands, whereas
+        // sign-extending to int16 and using vpmaddwd is exact.
+        inline int32_t dot_wide(const int8_t *a, const int8_t *b, size_t const n)
+        {
+            size_t k{0};
+            uint32_t s{0}; // Wrapping arithmetic; the true result fits in int32 for n < 2^17.
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+            __m512i const flip = _mm512_set1_epi8(char(0x80));
+            __m512i acc = _mm512_setzero_si512();
+            for (; k + 64 <= n; k += 64)
+            {
+                __m512i const va = _mm512_xor_si512(_mm512_loadu_si512(a + k), flip);
+                acc = _mm512_dpbusd_epi32(acc, va, _mm512_loadu_si512(b + k));
+            }
+            s = uint32_t(_mm512_reduce_add_epi32(acc));
+            for (; k < n; k++)
+            {
+                s += uint32_t((int32_t(a[k]) + 128) * int32_t(b[k]));
+            }
+            return int32_t(s);
+#else
+#if defined(__AVX512BW__)
+            __m512i acc512 = _mm512_setzero_si512();
+            for (; k + 32 <= n; k += 32)
+            {
+                __m512i const va = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + k)));
+                __m512i const vb = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k)));
+                acc512 = _mm512_add_epi32(acc512, _mm512_madd_epi16(va, vb));
+            }
+            s += uint32_t(_mm512_reduce_add_epi32(acc512));
+#endif
+#if defined(__AVX2__)
+            __m256i acc = _mm256_setzero_si256();
+            for (; k + 16 <= n; k += 16)
+            {
+                __m256i const va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + k)));
+                __m256i const vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + k)));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+            }
+            s += uint32_t(hsum_epi32(acc));
+#endif
+            for (; k < n; k++)
+            {
+                s += uint32_t(int32_t(a[k]) * int32_t(b[k]));
+            }
+            return int32_t(s);
+#endif
+        }
+
+        // Exact int16 dot product accumulated in int64. Products are formed in int32 lanes (|a*b| <= 2^30)
+        // and widened before they are summed.
+        inline int64_t dot_wide(const int16_t *a, const int16_t *b, size_t const n)
+        {
+            size_t k{0};
+            int64_t s{0};
+#if defined(__AVX512F__)
+            __m512i acc512 = _mm512_setzero_si512();
+            for (; k + 16 <= n; k += 16)
+            {
+                __m512i const va = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + k)));
+                __m512i const vb = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k)));
+                __m512i const p = _mm512_mullo_epi32(va, vb);
+                acc512 = _mm512_add_epi64(acc512, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(p)));
+                acc512 = _mm512_add_epi64(acc512, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(p, 1)));
+            }
+            s += _mm512_reduce_add_epi64(acc512);
+#endif
+#if defined(__AVX2__)
+            __m256i acc = _mm256_setzero_si256();
+            for (; k + 8 <= n; k += 8)
+            {
+                __m256i const va = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + k)));
+                __m256i const vb = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + k)));
+                __m256i const p = _mm256_mullo_epi32(va, vb);
+                acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p)));
+                acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1)));
+            }
+            s += hsum_epi64(acc);
+#endif
+            for (; k < n; k++)
+            {
+                s += int32_t(a[k]) * int32_t(b[k]);
+            }
+            return s;
+        }
+
+        // Portable wide dot product for the remaining element types.
+        template <class T>
+        accumulator_t<T> dot_wide(const T *a, const T *b, size_t const n)
+        {
+            accumulator_t<T> s{};
+            for (size_t k{0}; k < n; k++)
+            {
+                s += accumulator_t<T>(a[k]) * accumulator_t<T>(b[k]);
+            }
+            return s;
+        }
+
+        // C = A * B in accumulator_t<T>; store(i, j, acc) receives every result. B is packed transposed
+        // so every product is a contiguous dot; rows of A are split across threads and walk B^T in
+        // L1-sized column panels.
+        template <class T, size_t M, size_t K, size_t N, class Store>
+        void gemm_wide(const T *a, size_t lda, const T *b, size_t ldb, Store &&store)
+        {
+            using Acc = accumulator_t<T>;
+            constexpr bool biased = std::is_same_v<T, int8_t> && int8_dot_biased;
+
+            std::vector<T> bt(N * K);
+            for (size_t k{0}; k < K; k++)
+            {
+                for (size_t j{0}; j < N; j++)
+                {
+                    bt[j * K + k] = b[k * ldb + j];
+                }
+            }
+
+            std::vector<uint32_t> correction(biased ? N : 0);
+            if constexpr (biased)
+            {
+                for (size_t j{0}; j < N; j++)
+                {
+                    int32_t col{0};
+                    for (size_t k{0}; k < K; k++)
+                    {
+                        col += bt[j * K + k];
+                    }
+                    correction[j] = uint32_t(col) * 128u;
+                }
+            }
+
+            size_t const panel = std::max<size_t>(1, wide_panel_bytes / (K * sizeof(T)));
+            size_t const grain = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, K * N));
+            parallel_for(0, M, grain, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t j0{0}; j0 < N; j0 += panel)
+                             {
+                                 size_t const j1 = std::min(N, j0 + panel);
+                                 for (size_t i{lo}; i < hi; i++)
+                                 {
+                                     for (size_t j{j0}; j < j1; j++)
+                                     {
+                                         Acc acc = dot_wide(a + i * lda, bt.data() + j * K, K);
+                                         if constexpr (biased)
+                                         {
+                                             acc = Acc(uint32_t(acc) - correction[j]);
+                                         }
+                                         store(i, j, acc);
+                                     }
+                                 }
+                             } });
+        }
+
+    } // namespace detail
+
+    // Matrix multiplication that accumulates in accumulator_t<T> and returns the wide result
+    // (int8 -> int32, int16 -> int64, int32 -> int64). Inner dimensions beyond detail::wide_depth<T>,
+    // where full-range operands could overflow the accumulator, are rejected at compile time.
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2>
+    SimpleMatrix<accumulator_t<T>, ROW1, COL2, result_layout_t<S1>> multiply_wide(const SimpleMatrix<T, ROW1, COL1, S1> &a, const SimpleMatrix<T, ROW2, COL2, S2> &b)
+    {
+        static_assert(COL1 == ROW2, "Matrix dimensions are incompatible for multiplication.");
+        static_assert(COL1 <= detail::wide_depth<T>, "The inner dimension could overflow accumulator_t<T>.");
+        MATRIX_INSTRUMENT_SCOPE("multiply_wide", ROW1, COL2, COL1, 2 * ROW1 * COL1 * COL2,
+                                (ROW1 * COL1 + COL1 * COL2) * sizeof(T) + ROW1 * COL2 * sizeof(accumulator_t<T>));
+
+        SimpleMatrix<accumulator_t<T>, ROW1, COL2, result_layout_t<S1>> result;
+        detail::gemm_wide<T, ROW1, COL1, COL2>(a.data(), a.stride(), b.data(), b.stride(), [&](size_t i, size_t j, accumulator_t<T> acc)
+                                               { result.row(i)[j] = acc; });
+        return result;
+    }
+
+    // Dequantizing matrix multiplication: C[i][j] = row_scale[i] * col_scale[j] * sum_k A[i][k] * B[k][j],
+    // with the sum accumulated exactly in accumulator_t<T> (see multiply_wide for the depth limit).
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2>
+    SimpleMatrix<float, ROW1, COL2, result_layout_t<S1>> multiply_scaled(const SimpleMatrix<T, ROW1, COL1, S1> &a, const SimpleMatrix<T, ROW2, COL2, S2> &b,
+                                                                         const std::array<float, ROW1> &row_scale, const std::array<float, COL2> &col_scale)
+    {
+        static_assert(COL1 == ROW2, "Matrix dimensions are incompatible for multiplication.");
+        static_assert(COL1 <= detail::wide_depth<T>, "The inner dimension could overflow accumulator_t<T>.");
+        MATRIX_INSTRUMENT_SCOPE("multiply_scaled", ROW1, COL2, COL1, 2 * ROW1 * COL1 * COL2,
+                                (ROW1 * COL1 + COL1 * COL2) * sizeof(T) + ROW1 * COL2 * sizeof(float));
+
+        SimpleMatrix<float, ROW1, COL2, result_layout_t<S1>> result;
+        detail::gemm_wide<T, ROW1, COL1, COL2>(a.data(), a.stride(), b.data(), b.stride(), [&](size_t i, size_t j, accumulator_t<T> acc)
+                                               { result.row(i)[j] = float(acc) * row_scale[i] * col_scale[j]; });
+        return result;
+    }
+
+    // Dequantizing matrix multiplication with one scale per operand.
+    template <class T, size_t ROW1, size_t COL1, size_t ROW2, size_t COL2, class S1, class S2>
+    SimpleMatrix<float, ROW1, COL2, result_layout_t<S1>> multiply_scaled(const SimpleMatrix<T, ROW1, COL1, S1> &a, const SimpleMatrix<T, ROW2, COL2, S2> &b,
+                                                                         float const a_scale, float const b_scale)
+    {
+        static_assert(COL1 == ROW2, "Matrix dimensions are incompatible for multiplication.");
+        static_assert(COL1 <= detail::wide_depth<T>, "The inner dimension could overflow accumulator_t<T>.");
+        MATRIX_INSTRUMENT_SCOPE("multiply_scaled", ROW1, COL2, COL1, 2 * ROW1 * COL1 * COL2,
+                                (ROW1 * COL1 + COL1 * COL2) * sizeof(T) + ROW1 * COL2 * sizeof(float));
+
+        float const scale = a_scale * b_scale;
+        SimpleMatrix<float, ROW1, COL2, result_layout_t<S1>> result;
+        detail::gemm_wide<T, ROW1, COL1, COL2>(a.data(), a.stride(), b.data(), b.stride(), [&](size_t i, size_t j, accumulator_t<T> acc)
+                                               { result.row(i)[j] = float(acc) * scale; });
+        return result;
+    }
+
+} // namespace matrix
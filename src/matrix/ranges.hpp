@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+#include "matrix_base.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // Edge of the default square tiles: the largest power of two whose tile of T fits in 32 KiB, a
+    // typical L1 data cache.
+    template <class T>
+    inline constexpr size_t default_tile = []
+    {
+        size_t side{1};
+        while (4 * side * side * sizeof(T) <= (size_t{1} << 15))
+        {
+            side *= 2;
+        }
+        return side;
+    }();
+
+    // Tile: The rows x cols block of a matrix whose first element is (row0, col0). Edge tiles are
+    // smaller than the requested tile size.
+    template <class T>
+    struct Tile
+    {
+        T *data{nullptr}; // Element (row0, col0) of the matrix.
+        size_t stride{0}; // Distance in elements between consecutive rows.
+        size_t row0{0};
+        size_t col0{0};
+        size_t rows{0};
+        size_t cols{0};
+
+        // Row i of the tile, contiguous.
+        std::span<T> row(size_t const i) const
+        {
+            return {data + i * stride, cols};
+        }
+
+        // Element (i, j) of the tile (unchecked).
+        T &operator()(size_t const i, size_t const j) const
+        {
+            return data[i * stride + j];
+        }
+    };
+
+    namespace detail
+    {
+
+        // StridedIterator: Random-access iterator over every stride-th element from base; it keeps an
+        // index rather than a pointer so the end of a column never points outside the matrix.
+        template <class T>
+        class StridedIterator
+        {
+            T *base_{nullptr};
+            std::ptrdiff_t stride_{0};
+            std::ptrdiff_t i_{0};
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::remove_cv_t<T>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T *;
+            using reference = T &;
+
+            StridedIterator() = default;
+
+            StridedIterator(T *base, std::ptrdiff_t const stride, std::ptrdiff_t const i) : base_(base), stride_(stride), i_(i) {}
+
+            T &operator*() const
+            {
+                return base_[i_ * stride_];
+            }
+
+            T &operator[](std::ptrdiff_t const n) const
+            {
+                return base_[(i_ + n) * stride_];
+            }
+
+            StridedIterator &operator++()
+            {
+                ++i_;
+                return *this;
+            }
+
+            StridedIterator operator++(int)
+            {
+                auto old = *this;
+                ++i_;
+                return old;
+            }
+
+            StridedIterator &operator--()
+            {
+                --i_;
+                return *this;
+            }
+
+            StridedIterator operator--(int)
+            {
+                auto old = *this;
+                --i_;
+                return old;
+            }
+
+            StridedIterator &operator+=(std::ptrdiff_t const n)
+            {
+                i_ += n;
+                return *this;
+            }
+
+            StridedIterator &operator-=(std::ptrdiff_t const n)
+            {
+                i_ -= n;
+                return *this;
+            }
+
+            friend StridedIterator operator+(StridedIterator it, std::ptrdiff_t const n)
+            {
+                return it += n;
+            }
+
+            friend StridedIterator operator+(std::ptrdiff_t const n, StridedIterator it)
+            {
+                return it += n;
+            }
+
+            friend StridedIterator operator-(StridedIterator it, std::ptrdiff_t const n)
+            {
+                return it -= n;
+            }
+
+            friend std::ptrdiff_t operator-(const StridedIterator &a, const StridedIterator &b)
+            {
+                return a.i_ - b.i_;
+            }
+
+            friend bool operator==(const StridedIterator &a, const StridedIterator &b)
+            {
+                return a.i_ == b.i_;
+            }
+
+            friend std::strong_ordering operator<=>(const StridedIterator &a, const StridedIterator &b)
+            {
+                return a.i_ <=> b.i_;
+            }
+        };
+
+        // IndexIterator: Random-access iterator over the views make(0), make(1), ... of a matrix. The
+        // views are returned by value, so, like std::ranges::iota_view, it is random access for
+        // std::ranges but only a legacy input iterator.
+        template <class Make>
+        class IndexIterator
+        {
+            Make make_{};
+            std::ptrdiff_t i_{0};
+
+        public:
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::invoke_result_t<const Make &, size_t>;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type;
+
+            IndexIterator() = default;
+
+            IndexIterator(Make make, std::ptrdiff_t const i) : make_(make), i_(i) {}
+
+            value_type operator*() const
+            {
+                return make_(size_t(i_));
+            }
+
+            value_type operator[](std::ptrdiff_t const n) const
+            {
+                return make_(size_t(i_ + n));
+            }
+
+            IndexIterator &operator++()
+            {
+                ++i_;
+                return *this;
+            }
+
+            IndexIterator operator++(int)
+            {
+                auto old = *this;
+                ++i_;
+                return old;
+            }
+
+            IndexIterator &operator--()
+            {
+                --i_;
+                return *this;
+            }
+
+            IndexIterator operator--(int)
+            {
+                auto old = *this;
+                --i_;
+                return old;
+            }
+
+            IndexIterator &operator+=(std::ptrdiff_t const n)
+            {
+                i_ += n;
+                return *this;
+            }
+
+            IndexIterator &operator-=(std::ptrdiff_t const n)
+            {
+                i_ -= n;
+                return *this;
+            }
+
+            friend IndexIterator operator+(IndexIterator it, std::ptrdiff_t const n)
+            {
+                return it += n;
+            }
+
+            friend IndexIterator operator+(std::ptrdiff_t const n, IndexIterator it)
+            {
+                return it += n;
+            }
+
+            friend IndexIterator operator-(IndexIterator it, std::ptrdiff_t const n)
+            {
+                return it -= n;
+            }
+
+            friend std::ptrdiff_t operator-(const IndexIterator &a, const IndexIterator &b)
+            {
+                return a.i_ - b.i_;
+            }
+
+            friend bool operator==(const IndexIterator &a, const IndexIterator &b)
+            {
+                return a.i_ == b.i_;
+            }
+
+            friend std::strong_ordering operator<=>(const IndexIterator &a, const IndexIterator &b)
+            {
+                return a.i_ <=> b.i_;
+            }
+        };
+
+        // IndexRange: The sized view make(0), ..., make(size - 1).
+        template <class Make>
+        class IndexRange : public std::ranges::view_interface<IndexRange<Make>>
+        {
+            Make make_{};
+            size_t size_{0};
+
+        public:
+            IndexRange() = default;
+
+            IndexRange(Make make, size_t const size) : make_(make), size_(size) {}
+
+            IndexIterator<Make> begin() const
+            {
+                return {make_, 0};
+            }
+
+            IndexIterator<Make> end() const
+            {
+                return {make_, std::ptrdiff_t(size_)};
+            }
+
+            size_t size() const
+            {
+                return size_;
+            }
+        };
+
+        template <class T, size_t COL>
+        struct RowAt
+        {
+            T *data{nullptr};
+            size_t stride{0};
+
+            std::span<T, COL> operator()(size_t const r) const
+            {
+                return std::span<T, COL>(data + r * stride, COL);
+            }
+        };
+
+        template <class T, size_t ROW>
+        struct ColAt
+        {
+            T *data{nullptr};
+            size_t stride{0};
+
+            std::ranges::subrange<StridedIterator<T>> operator()(size_t const c) const
+            {
+                return {StridedIterator<T>(data + c, std::ptrdiff_t(stride), 0), StridedIterator<T>(data + c, std::ptrdiff_t(stride), ROW)};
+            }
+        };
+
+        // Tiles are numbered row-major: tile t covers tile row t / across and tile column t % across.
+        template <class T, size_t ROW, size_t COL, size_t TR, size_t TC>
+        struct TileAt
+        {
+            T *data{nullptr};
+            size_t stride{0};
+
+            static constexpr size_t across = (COL + TC - 1) / TC;
+            static constexpr size_t count = (ROW + TR - 1) / TR * across;
+
+            Tile<T> operator()(size_t const t) const
+            {
+                size_t const r0 = t / across * TR;
+                size_t const c0 = t % across * TC;
+                return {data + r0 * stride + c0, stride, r0, c0, std::min(TR, ROW - r0), std::min(TC, COL - c0)};
+            }
+        };
+
+    } // namespace detail
+
+    // Rows of a matrix as a random-access range of std::span<T, COL>; each row is contiguous.
+    template <class T, size_t ROW, size_t COL, class S>
+    auto rows(SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        return detail::IndexRange(detail::RowAt<T, COL>{m.data(), m.stride()}, ROW);
+    }
+
+    template <class T, size_t ROW, size_t COL, class S>
+    auto rows(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        return detail::IndexRange(detail::RowAt<const T, COL>{m.data(), m.stride()}, ROW);
+    }
+
+    // Columns of a matrix as a random-access range of random-access subranges that step by the row
+    // stride, so std::ranges algorithms such as sort work down a column in place.
+    template <class T, size_t ROW, size_t COL, class S>
+    auto cols(SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        return detail::IndexRange(detail::ColAt<T, ROW>{m.data(), m.stride()}, COL);
+    }
+
+    template <class T, size_t ROW, size_t COL, class S>
+    auto cols(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        return detail::IndexRange(detail::ColAt<const T, ROW>{m.data(), m.stride()}, COL);
+    }
+
+    // TR x TC tiles of a matrix in row-major tile order, as a random-access range of Tile<T>; a size of
+    // 0 means default_tile<T>. Tiles do not overlap, so they can be processed concurrently.
+    template <size_t TR = 0, size_t TC = TR, class T, size_t ROW, size_t COL, class S>
+    auto tiles(SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        using At = detail::TileAt<T, ROW, COL, TR == 0 ? default_tile<T> : TR, TC == 0 ? default_tile<T> : TC>;
+        return detail::IndexRange(At{m.data(), m.stride()}, At::count);
+    }
+
+    template <size_t TR = 0, size_t TC = TR, class T, size_t ROW, size_t COL, class S>
+    auto tiles(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        using At = detail::TileAt<const T, ROW, COL, TR == 0 ? default_tile<T> : TR, TC == 0 ? default_tile<T> : TC>;
+        return detail::IndexRange(At{m.data(), m.stride()}, At::count);
+    }
+
+    // Call f on every element of a random-access range (rows, cols or tiles) on the library thread pool.
+    // Each thread takes an even, contiguous share of the elements, grain or more at a time.
+    template <std::ranges::random_access_range R, class F>
+        requires std::ranges::sized_range<R>
+    void parallel_for_each(R &&range, F &&f, size_t const grain = 1)
+    {
+        auto const first = std::ranges::begin(range);
+        parallel_for(0, size_t(std::ranges::size(range)), grain, [&](size_t lo, size_t hi)
+                     {
+                         for (size_t i{lo}; i < hi; i++)
+                         {
+                             f(first[std::ptrdiff_t(i)]);
+                         } });
+    }
+
+} // namespace matrix
@@ -0,0 +1,910 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "matrix_base.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // How sums are accumulated. Plain keeps one running sum per vector lane. Kahan also carries each
+    // lane's rounding error. Pairwise sums blocks of pairwise_block elements and adds the block sums
+    // in a balanced tree. Blocks are always combined in a fixed tree, so results do not depend on the
+    // number of threads.
+    enum class Summation
+    {
+        Plain,
+        Kahan,
+        Pairwise,
+    };
+
+    // Entrywise norms: the sum of magnitudes, the square root of the sum of squares (Frobenius for
+    // a whole matrix) and the largest magnitude.
+    enum class Norm
+    {
+        L1,
+        L2,
+        Inf,
+    };
+
+    // Extremum: Value and position of the smallest or largest element.
+    template <class T>
+    struct Extremum
+    {
+        T value;
+        size_t row;
+        size_t col;
+    };
+
+    // Extrema: Smallest or largest element of every row (a column of results, indices are columns) or
+    // of every column (a row of results, indices are rows).
+    template <class T, size_t ROW, size_t COL>
+    struct Extrema
+    {
+        SimpleMatrix<T, ROW, COL> values;
+        SimpleMatrix<size_t, ROW, COL> indices;
+    };
+
+    // Elements summed plainly before Pairwise summation starts combining in a tree.
+    inline constexpr size_t pairwise_block = 128;
+
+    namespace detail
+    {
+
+        // Independent accumulators per kernel: one 64-byte vector of A, so the lane loop maps onto
+        // whole SIMD registers.
+        template <class A>
+        inline constexpr size_t reduce_lanes = std::max<size_t>(1, 64 / sizeof(A));
+
+        // Type a reduction reads elements as: float for the compact floats, T otherwise.
+        template <class T>
+        using load_t = std::conditional_t<is_compact_float_v<T>, float, T>;
+
+        // Floating-point type of means and L2 norms.
+        template <class A>
+        using real_t = std::conditional_t<std::is_floating_point_v<A>, A, double>;
+
+        template <class A>
+        A magnitude(A const x)
+        {
+            if constexpr (std::is_unsigned_v<A>)
+            {
+                return x;
+            }
+            else
+            {
+                return x < A{} ? -x : x;
+            }
+        }
+
+        template <class A>
+        bool is_nan(A const x)
+        {
+            if constexpr (std::is_floating_point_v<A>)
+            {
+                return std::isnan(x);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        // True when a should replace b as the running extremum. NaNs never replace a number, and any
+        // number replaces a NaN.
+        template <bool MAX, class U>
+        bool better(U const a, U const b)
+        {
+            return (MAX ? a > b : a < b) | (is_nan(b) & !is_nan(a)); // Branch-free, so lane loops vectorize.
+        }
+
+        // Partial: A sum and the compensation that corrects its rounding error; the value is sum + comp.
+        template <class A>
+        struct Partial
+        {
+            A sum{};
+            A comp{};
+
+            A value() const
+            {
+                return sum + comp;
+            }
+        };
+
+        // Add two partials; floating-point sums keep the exact rounding error of the addition (TwoSum).
+        template <class A>
+        Partial<A> combine(Partial<A> const a, Partial<A> const b)
+        {
+            if constexpr (std::is_floating_point_v<A>)
+            {
+                A const s = a.sum + b.sum;
+                A const bs = s - a.sum;
+                A const err = (a.sum - (s - bs)) + (b.sum - bs);
+                return {s, a.comp + b.comp + err};
+            }
+            else
+            {
+                return {a.sum + b.sum, a.comp + b.comp};
+            }
+        }
+
+        // Sum of term(begin) ... term(end - 1) in reduce_lanes<A> interleaved lanes.
+        template <class A, class F>
+        Partial<A> sum_terms(size_t const begin, size_t const end, Summation const how, F &&term)
+        {
+            constexpr size_t L = reduce_lanes<A>;
+            if (how == Summation::Pairwise && end - begin > pairwise_block)
+            {
+                size_t const mid = begin + (end - begin) / 2 / L * L;
+                return combine(sum_terms<A>(begin, mid, how, term), sum_terms<A>(mid, end, how, term));
+            }
+
+            A s[L]{};
+            A c[L]{};
+            size_t const body = end - (end - begin) % L;
+            if (how == Summation::Kahan)
+            {
+                for (size_t k{begin}; k < body; k += L)
+                {
+                    for (size_t l{0}; l < L; l++)
+                    {
+                        A const y = term(k + l) - c[l];
+                        A const t = s[l] + y;
+                        c[l] = (t - s[l]) - y;
+                        s[l] = t;
+                    }
+                }
+            }
+            else
+            {
+                for (size_t k{begin}; k < body; k += L)
+                {
+                    for (size_t l{0}; l < L; l++)
+                    {
+                        s[l] += term(k + l);
+                    }
+                }
+            }
+            Partial<A> result;
+            for (size_t k{body}; k < end; k++)
+            {
+                result = combine(result, {term(k), A{}});
+            }
+            if (how != Summation::Kahan)
+            {
+                // Fold the lanes in halves; only Kahan lanes carry compensation worth keeping.
+                for (size_t w{L / 2}; w > 0; w /= 2)
+                {
+                    for (size_t l{0}; l < w; l++)
+                    {
+                        s[l] += s[l + w];
+                    }
+                }
+                return combine(result, {s[0], A{}});
+            }
+            for (size_t l{0}; l < L; l++)
+            {
+                result = combine(result, {s[l], -c[l]}); // Kahan's c is the excess added to s.
+            }
+            return result;
+        }
+
+        // Call f(q, len, offset) on consecutive pieces of p[0, n) read as load_t<T>: the span itself, or
+        // float copies of at most convert_block elements for the compact floats.
+        template <class T, class F>
+        void for_each_piece(const T *p, size_t const n, F &&f)
+        {
+            if constexpr (is_compact_float_v<T>)
+            {
+                float buffer[convert_block];
+                for (size_t i{0}; i < n; i += convert_block)
+                {
+                    size_t const len = std::min(convert_block, n - i);
+                    widen(p + i, buffer, len);
+                    f(static_cast<const float *>(buffer), len, i);
+                }
+            }
+            else
+            {
+                f(p, n, size_t{0});
+            }
+        }
+
+        // Sum of term(x) over the span p[0, n).
+        template <class A, class T, class Term>
+        Partial<A> reduce_span(const T *p, size_t const n, Summation const how, Term &&term)
+        {
+            Partial<A> total;
+            for_each_piece(p, n, [&](const auto *q, size_t len, size_t)
+                           { total = combine(total, sum_terms<A>(0, len, how, [&](size_t k)
+                                                                  { return term(q[k]); })); });
+            return total;
+        }
+
+        // Sum of A(a[k]) * A(b[k]) over two spans.
+        template <class A, class T>
+        Partial<A> dot_span(const T *a, const T *b, size_t const n, Summation const how)
+        {
+            if constexpr (is_compact_float_v<T>)
+            {
+                Partial<A> total;
+                float wb[convert_block];
+                for_each_piece(a, n, [&](const float *q, size_t len, size_t offset)
+                               {
+                                   widen(b + offset, wb, len);
+                                   total = combine(total, sum_terms<A>(0, len, how, [&](size_t k)
+                                                                       { return A(q[k]) * A(wb[k]); })); });
+                return total;
+            }
+            else
+            {
+                return sum_terms<A>(0, n, how, [&](size_t k)
+                                    { return A(a[k]) * A(b[k]); });
+            }
+        }
+
+        // Largest magnitude in a span; a NaN anywhere makes the result NaN.
+        template <class A, class T>
+        A max_magnitude(const T *p, size_t const n)
+        {
+            constexpr size_t L = reduce_lanes<A>;
+            A result{};
+            for_each_piece(p, n, [&](const auto *q, size_t len, size_t)
+                           {
+                               A m[L]{};
+                               size_t const body = len - len % L;
+                               for (size_t k{0}; k < body; k += L)
+                               {
+                                   for (size_t l{0}; l < L; l++)
+                                   {
+                                       A const v = magnitude(A(q[k + l]));
+                                       m[l] = (v > m[l] || is_nan(v)) ? v : m[l];
+                                   }
+                               }
+                               for (size_t k{body}; k < len; k++)
+                               {
+                                   A const v = magnitude(A(q[k]));
+                                   m[0] = (v > m[0] || is_nan(v)) ? v : m[0];
+                               }
+                               for (size_t l{0}; l < L; l++)
+                               {
+                                   result = (m[l] > result || is_nan(m[l])) ? m[l] : result;
+                               } });
+            return result;
+        }
+
+        // Smallest (MAX false) or largest element of the non-empty span q[0, n), lane-parallel.
+        template <bool MAX, size_t L, class U>
+        U extreme_value(const U *q, size_t n)
+        {
+            U v = q[0];
+            if (n >= L)
+            {
+                U m[L];
+                std::copy(q, q + L, m);
+                size_t const body = n - n % L;
+                for (size_t k{L}; k < body; k += L)
+                {
+                    for (size_t l{0}; l < L; l++)
+                    {
+                        m[l] = better<MAX>(q[k + l], m[l]) ? q[k + l] : m[l];
+                    }
+                }
+                v = m[0];
+                for (size_t l{1}; l < L; l++)
+                {
+                    v = better<MAX>(m[l], v) ? m[l] : v;
+                }
+                q += body;
+                n -= body;
+            }
+            for (size_t k{0}; k < n; k++)
+            {
+                v = better<MAX>(q[k], v) ? q[k] : v;
+            }
+            return v;
+        }
+
+        // Index of the first smallest (MAX false) or largest element of the non-empty span p[0, n).
+        // NaNs are skipped unless every element is NaN, in which case the first one is reported.
+        template <bool MAX, class T>
+        size_t extremum_span(const T *p, size_t const n)
+        {
+            using U = load_t<T>;
+            constexpr size_t L = reduce_lanes<U>;
+            constexpr size_t chunk = 64 * L;
+            size_t index{0};
+            U best{};
+            bool found{false};
+            for_each_piece(p, n, [&](const U *q, size_t len, size_t offset)
+                           {
+                               // The extreme of each chunk, vectorized; then the first position inside the
+                               // earliest chunk holding the best one.
+                               size_t at{0};
+                               U v = q[0];
+                               for (size_t c{0}; c < len; c += chunk)
+                               {
+                                   U const e = extreme_value<MAX, L>(q + c, std::min(chunk, len - c));
+                                   if (c == 0 || better<MAX>(e, v))
+                                   {
+                                       v = e;
+                                       at = c;
+                                   }
+                               }
+                               while (!(q[at] == v || (is_nan(v) && is_nan(q[at]))))
+                               {
+                                   at++;
+                               }
+                               if (!found || better<MAX>(v, best))
+                               {
+                                   index = offset + at;
+                                   best = v;
+                                   found = true;
+                               } });
+            return index;
+        }
+
+        // Rows per block of a reduction over ROW x COL elements: enough work per block to be worth a
+        // task, and at most pairwise_block rows under Pairwise summation.
+        template <size_t ROW, size_t COL>
+        size_t block_rows(Summation const how)
+        {
+            size_t const rows = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, COL));
+            return std::min(ROW, how == Summation::Pairwise ? std::min(rows, pairwise_block) : rows);
+        }
+
+        // Combine values[lo, hi) in a balanced tree with f; the values are moved from.
+        template <class V, class F>
+        V combine_tree(std::vector<V> &values, size_t const lo, size_t const hi, F &&f)
+        {
+            if (hi - lo == 1)
+            {
+                return std::move(values[lo]);
+            }
+            size_t const mid = lo + (hi - lo) / 2;
+            return f(combine_tree(values, lo, mid, f), combine_tree(values, mid, hi, f));
+        }
+
+        // Reduce ROW rows in blocks of `rows` rows: block(r0, r1) gives a partial result, the blocks run
+        // in parallel and their results are combined with f in a fixed tree.
+        template <class V, class Block, class F>
+        V reduce_blocks(size_t const ROW, size_t const rows, Block &&block, F &&f)
+        {
+            size_t const blocks = (ROW + rows - 1) / rows;
+            if (blocks <= 1)
+            {
+                return block(size_t{0}, ROW);
+            }
+            std::vector<V> partials(blocks);
+            parallel_for(0, blocks, 1, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t b{lo}; b < hi; b++)
+                             {
+                                 partials[b] = block(b * rows, std::min(ROW, (b + 1) * rows));
+                             } });
+            return combine_tree(partials, 0, blocks, f);
+        }
+
+        // Sum of term(x) over every element of m.
+        template <class A, class T, size_t ROW, size_t COL, class S, class Term>
+        Partial<A> reduce_all(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how, Term &&term)
+        {
+            auto block = [&](size_t r0, size_t r1)
+            {
+                if constexpr (SimpleMatrix<T, ROW, COL, S>::contiguous)
+                {
+                    return reduce_span<A>(m.row(r0), (r1 - r0) * COL, how, term);
+                }
+                else
+                {
+                    Partial<A> total;
+                    for (size_t r{r0}; r < r1; r++)
+                    {
+                        total = combine(total, reduce_span<A>(m.row(r), COL, how, term));
+                    }
+                    return total;
+                }
+            };
+            return reduce_blocks<Partial<A>>(ROW, block_rows<ROW, COL>(how), block, combine<A>);
+        }
+
+        // out(r) = f(r) for every row, in parallel for large matrices.
+        template <size_t ROW, size_t COL, class F>
+        void for_each_row(F &&f)
+        {
+            parallel_for(0, ROW, std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, COL)), [&](size_t lo, size_t hi)
+                         {
+                             for (size_t r{lo}; r < hi; r++)
+                             {
+                                 f(r);
+                             } });
+        }
+
+        // Column partials: per-column sums and compensations of a block of rows.
+        template <class A>
+        struct ColumnPartial
+        {
+            std::vector<A> sum;
+            std::vector<A> comp;
+        };
+
+        // s += t over N columns, with Kahan compensation in c when `kahan` is set. The columns are the
+        // vector lanes; the restrict qualifiers let the compiler vectorize without alias checks.
+        template <size_t N, class A>
+        void accumulate(A *__restrict s, A *__restrict c, const A *__restrict t, bool const kahan)
+        {
+            if (kahan)
+            {
+                for (size_t j{0}; j < N; j++)
+                {
+                    A const y = t[j] - c[j];
+                    A const sum = s[j] + y;
+                    c[j] = (sum - s[j]) - y;
+                    s[j] = sum;
+                }
+            }
+            else
+            {
+                for (size_t j{0}; j < N; j++)
+                {
+                    s[j] += t[j];
+                }
+            }
+        }
+
+        // dst[j] = term(src[j]) for j < n.
+        template <class A, class U, class Term>
+        void transform(const U *__restrict src, A *__restrict dst, size_t const n, Term &&term)
+        {
+            for (size_t j{0}; j < n; j++)
+            {
+                dst[j] = term(src[j]);
+            }
+        }
+
+        // Per-column sums of load(r, dst), which writes the COL terms of row r to dst.
+        template <class A, size_t ROW, size_t COL, class Load>
+        std::vector<A> reduce_columns(Summation const how, Load &&load)
+        {
+            auto block = [&](size_t r0, size_t r1)
+            {
+                ColumnPartial<A> p{std::vector<A>(COL), std::vector<A>(COL)};
+                std::vector<A> terms(COL);
+                A *s = p.sum.data();
+                A *c = p.comp.data();
+                const A *t = terms.data();
+                for (size_t r{r0}; r < r1; r++)
+                {
+                    load(r, terms.data());
+                    accumulate<COL>(s, c, t, how == Summation::Kahan);
+                }
+                for (size_t j{0}; j < COL; j++)
+                {
+                    c[j] = -c[j];
+                }
+                return p;
+            };
+            auto merge = [](ColumnPartial<A> a, const ColumnPartial<A> &b)
+            {
+                for (size_t j{0}; j < COL; j++)
+                {
+                    Partial<A> const s = combine<A>({a.sum[j], a.comp[j]}, {b.sum[j], b.comp[j]});
+                    a.sum[j] = s.sum;
+                    a.comp[j] = s.comp;
+                }
+                return a;
+            };
+            ColumnPartial<A> const total = reduce_blocks<ColumnPartial<A>>(ROW, block_rows<ROW, COL>(how), block, merge);
+            std::vector<A> result(COL);
+            for (size_t j{0}; j < COL; j++)
+            {
+                result[j] = total.sum[j] + total.comp[j];
+            }
+            return result;
+        }
+
+        // Write row r of m to dst as A, transformed by term.
+        template <class A, class T, size_t ROW, size_t COL, class S, class Term>
+        void load_row(const SimpleMatrix<T, ROW, COL, S> &m, size_t const r, A *dst, Term &&term)
+        {
+            for_each_piece(m.row(r), COL, [&](const auto *q, size_t len, size_t offset)
+                           { transform(q, dst + offset, len, term); });
+        }
+
+        // best = max(best, v) over N columns, letting NaNs through.
+        template <size_t N, class A>
+        void max_into(A *__restrict best, const A *__restrict v)
+        {
+            for (size_t j{0}; j < N; j++)
+            {
+                best[j] = (v[j] > best[j] || is_nan(v[j])) ? v[j] : best[j];
+            }
+        }
+
+        // Largest magnitude of every column; a NaN makes its column NaN.
+        template <class A, size_t ROW, size_t COL, class T, class S>
+        std::vector<A> max_magnitude_columns(const SimpleMatrix<T, ROW, COL, S> &m)
+        {
+            auto block = [&](size_t r0, size_t r1)
+            {
+                std::vector<A> best(COL);
+                std::vector<A> values(COL);
+                for (size_t r{r0}; r < r1; r++)
+                {
+                    load_row(m, r, values.data(), [](auto x)
+                             { return magnitude(A(x)); });
+                    max_into<COL>(best.data(), values.data());
+                }
+                return best;
+            };
+            auto merge = [](std::vector<A> a, const std::vector<A> &b)
+            {
+                max_into<COL>(a.data(), b.data());
+                return a;
+            };
+            return reduce_blocks<std::vector<A>>(ROW, block_rows<ROW, COL>(Summation::Plain), block, merge);
+        }
+
+        template <class A>
+        auto norm_term(Norm const norm)
+        {
+            return [norm](auto x)
+            {
+                A const v = A(x);
+                return norm == Norm::L2 ? v * v : magnitude(v);
+            };
+        }
+
+        template <class A>
+        real_t<A> finish_norm(A const total, Norm const norm)
+        {
+            return norm == Norm::L2 ? std::sqrt(real_t<A>(total)) : real_t<A>(total);
+        }
+
+        template <bool MAX, class T, size_t ROW, size_t COL, class S>
+        Extremum<T> extremum_all(const SimpleMatrix<T, ROW, COL, S> &m)
+        {
+            using U = load_t<T>;
+            auto block = [&](size_t r0, size_t r1)
+            {
+                // Rows of a contiguous block are one span; the index is split back into row and column.
+                if constexpr (SimpleMatrix<T, ROW, COL, S>::contiguous)
+                {
+                    size_t const k = extremum_span<MAX>(m.row(r0), (r1 - r0) * COL);
+                    return Extremum<T>{m.row(r0)[k], r0 + k / COL, k % COL};
+                }
+                else
+                {
+                    Extremum<T> best{m.row(r0)[0], r0, 0};
+                    for (size_t r{r0}; r < r1; r++)
+                    {
+                        size_t const c = extremum_span<MAX>(m.row(r), COL);
+                        if (r == r0 || better<MAX>(U(m.row(r)[c]), U(best.value)))
+                        {
+                            best = {m.row(r)[c], r, c};
+                        }
+                    }
+                    return best;
+                }
+            };
+            // Ties go to the left block, which holds the earlier elements.
+            auto pick = [](const Extremum<T> &a, const Extremum<T> &b)
+            { return better<MAX>(U(b.value), U(a.value)) ? b : a; };
+            return reduce_blocks<Extremum<T>>(ROW, block_rows<ROW, COL>(Summation::Plain), block, pick);
+        }
+
+        template <bool MAX, class T, size_t ROW, size_t COL, class S>
+        Extrema<T, ROW, 1> extremum_rows(const SimpleMatrix<T, ROW, COL, S> &m)
+        {
+            Extrema<T, ROW, 1> result;
+            for_each_row<ROW, COL>([&](size_t r)
+                                   {
+                                       size_t const c = extremum_span<MAX>(m.row(r), COL);
+                                       result.values.row(r)[0] = m.row(r)[c];
+                                       result.indices.row(r)[0] = c; });
+            return result;
+        }
+
+        // Column extrema: every row is compared elementwise against the running best of its block,
+        // then blocks are merged with ties going to the earlier rows.
+        template <bool MAX, class T, size_t ROW, size_t COL, class S>
+        Extrema<T, 1, COL> extremum_cols(const SimpleMatrix<T, ROW, COL, S> &m)
+        {
+            using U = load_t<T>;
+            struct Best
+            {
+                std::vector<U> value;
+                std::vector<size_t> row;
+            };
+            auto block = [&](size_t r0, size_t r1)
+            {
+                Best best{std::vector<U>(COL), std::vector<size_t>(COL, r0)};
+                load_row(m, r0, best.value.data(), [](U x)
+                         { return x; });
+                std::vector<U> values(COL);
+                for (size_t r{r0 + 1}; r < r1; r++)
+                {
+                    load_row(m, r, values.data(), [](U x)
+                             { return x; });
+                    for (size_t j{0}; j < COL; j++)
+                    {
+                        bool const b = better<MAX>(values[j], best.value[j]);
+                        best.value[j] = b ? values[j] : best.value[j];
+                        best.row[j] = b ? r : best.row[j];
+                    }
+                }
+                return best;
+            };
+            auto merge = [](Best a, const Best &b)
+            {
+                for (size_t j{0}; j < COL; j++)
+                {
+                    if (better<MAX>(b.value[j], a.value[j]))
+                    {
+                        a.value[j] = b.value[j];
+                        a.row[j] = b.row[j];
+                    }
+                }
+                return a;
+            };
+            Best const best = reduce_blocks<Best>(ROW, block_rows<ROW, COL>(Summation::Plain), block, merge);
+            Extrema<T, 1, COL> result;
+            for (size_t j{0}; j < COL; j++)
+            {
+                result.values[0][j] = m.row(best.row[j])[j];
+                result.indices[0][j] = best.row[j];
+            }
+            return result;
+        }
+
+        template <class Acc, class T>
+        using sum_t = std::conditional_t<std::is_void_v<Acc>, accumulator_t<T>, Acc>;
+
+    } // namespace detail
+
+    // Sum of all elements, accumulated in Acc (by default accumulator_t<T>: float for half and bfloat16).
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto sum(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("sum", 1, 1, ROW * COL, ROW * COL, ROW * COL * sizeof(T));
+        return detail::reduce_all<A>(m, how, [](auto x)
+                                     { return A(x); })
+            .value();
+    }
+
+    // Mean of all elements; integer matrices are summed exactly and divided in double.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto mean(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how = Summation::Plain)
+    {
+        using R = detail::real_t<detail::sum_t<Acc, T>>;
+        return R(sum<Acc>(m, how)) / R(ROW * COL);
+    }
+
+    // Sum of the elementwise products of two matrices of the same shape (the Frobenius inner product).
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S1, class S2>
+    auto dot(const SimpleMatrix<T, ROW, COL, S1> &a, const SimpleMatrix<T, ROW, COL, S2> &b, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("dot", 1, 1, ROW * COL, 2 * ROW * COL, 2 * ROW * COL * sizeof(T));
+        constexpr bool contiguous = SimpleMatrix<T, ROW, COL, S1>::contiguous && SimpleMatrix<T, ROW, COL, S2>::contiguous;
+        auto block = [&](size_t r0, size_t r1)
+        {
+            if constexpr (contiguous)
+            {
+                return detail::dot_span<A>(a.row(r0), b.row(r0), (r1 - r0) * COL, how);
+            }
+            else
+            {
+                detail::Partial<A> total;
+                for (size_t r{r0}; r < r1; r++)
+                {
+                    total = detail::combine(total, detail::dot_span<A>(a.row(r), b.row(r), COL, how));
+                }
+                return total;
+            }
+        };
+        return detail::reduce_blocks<detail::Partial<A>>(ROW, detail::block_rows<ROW, COL>(how), block, detail::combine<A>).value();
+    }
+
+    // Entrywise norm of a matrix; integer matrices give a double.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto norm(const SimpleMatrix<T, ROW, COL, S> &m, Norm const norm = Norm::L2, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("norm", 1, 1, ROW * COL, (norm == Norm::L2 ? 2 : 1) * ROW * COL, ROW * COL * sizeof(T));
+        if (norm == Norm::Inf)
+        {
+            auto block = [&](size_t r0, size_t r1)
+            {
+                A result{};
+                for (size_t r{r0}; r < r1; r++)
+                {
+                    A const v = detail::max_magnitude<A>(m.row(r), COL);
+                    result = (v > result || detail::is_nan(v)) ? v : result;
+                }
+                return result;
+            };
+            auto pick = [](A a, A b)
+            { return (b > a || detail::is_nan(b)) ? b : a; };
+            return detail::real_t<A>(detail::reduce_blocks<A>(ROW, detail::block_rows<ROW, COL>(how), block, pick));
+        }
+        return detail::finish_norm(detail::reduce_all<A>(m, how, detail::norm_term<A>(norm)).value(), norm);
+    }
+
+    // Smallest element and its position; ties go to the first in row-major order and NaNs are skipped.
+    template <class T, size_t ROW, size_t COL, class S>
+    Extremum<T> argmin(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("argmin", 1, 1, ROW * COL, ROW * COL, ROW * COL * sizeof(T));
+        return detail::extremum_all<false>(m);
+    }
+
+    // Largest element and its position; ties go to the first in row-major order and NaNs are skipped.
+    template <class T, size_t ROW, size_t COL, class S>
+    Extremum<T> argmax(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("argmax", 1, 1, ROW * COL, ROW * COL, ROW * COL * sizeof(T));
+        return detail::extremum_all<true>(m);
+    }
+
+    // Sum of every row, as a column.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto row_sums(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("row_sums", ROW, 1, COL, ROW * COL, ROW * COL * sizeof(T));
+        SimpleMatrix<A, ROW, 1> result;
+        detail::for_each_row<ROW, COL>([&](size_t r)
+                                       { result.row(r)[0] = detail::reduce_span<A>(m.row(r), COL, how, [](auto x)
+                                                                               { return A(x); })
+                                                            .value(); });
+        return result;
+    }
+
+    // Sum of every column, as a row. Rows are added elementwise, so the columns are the vector lanes.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto col_sums(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("col_sums", 1, COL, ROW, ROW * COL, ROW * COL * sizeof(T));
+        std::vector<A> const sums = detail::reduce_columns<A, ROW, COL>(how, [&](size_t r, A *dst)
+                                                                         { detail::load_row(m, r, dst, [](auto x)
+                                                                                            { return A(x); }); });
+        SimpleMatrix<A, 1, COL> result;
+        std::copy(sums.begin(), sums.end(), result.row(0));
+        return result;
+    }
+
+    // Mean of every row, as a column.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto row_means(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how = Summation::Plain)
+    {
+        using R = detail::real_t<detail::sum_t<Acc, T>>;
+        auto const sums = row_sums<Acc>(m, how);
+        SimpleMatrix<R, ROW, 1> result;
+        for (size_t r{0}; r < ROW; r++)
+        {
+            result[r][0] = R(sums.at(r, 0)) / R(COL);
+        }
+        return result;
+    }
+
+    // Mean of every column, as a row.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto col_means(const SimpleMatrix<T, ROW, COL, S> &m, Summation const how = Summation::Plain)
+    {
+        using R = detail::real_t<detail::sum_t<Acc, T>>;
+        auto const sums = col_sums<Acc>(m, how);
+        SimpleMatrix<R, 1, COL> result;
+        for (size_t c{0}; c < COL; c++)
+        {
+            result[0][c] = R(sums.at(0, c)) / R(ROW);
+        }
+        return result;
+    }
+
+    // Dot product of every pair of corresponding rows, as a column.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S1, class S2>
+    auto row_dots(const SimpleMatrix<T, ROW, COL, S1> &a, const SimpleMatrix<T, ROW, COL, S2> &b, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("row_dots", ROW, 1, COL, 2 * ROW * COL, 2 * ROW * COL * sizeof(T));
+        SimpleMatrix<A, ROW, 1> result;
+        detail::for_each_row<ROW, COL>([&](size_t r)
+                                       { result.row(r)[0] = detail::dot_span<A>(a.row(r), b.row(r), COL, how).value(); });
+        return result;
+    }
+
+    // Dot product of every pair of corresponding columns, as a row.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S1, class S2>
+    auto col_dots(const SimpleMatrix<T, ROW, COL, S1> &a, const SimpleMatrix<T, ROW, COL, S2> &b, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("col_dots", 1, COL, ROW, 2 * ROW * COL, 2 * ROW * COL * sizeof(T));
+        std::vector<A> const sums = detail::reduce_columns<A, ROW, COL>(how, [&](size_t r, A *dst)
+                                                                         {
+                                                                             detail::load_row(a, r, dst, [](auto x)
+                                                                                              { return A(x); });
+                                                                             detail::for_each_piece(b.row(r), COL, [&](const auto *q, size_t len, size_t offset)
+                                                                                                    {
+                                                                                                        for (size_t j{0}; j < len; j++)
+                                                                                                        {
+                                                                                                            dst[offset + j] *= A(q[j]);
+                                                                                                        } }); });
+        SimpleMatrix<A, 1, COL> result;
+        std::copy(sums.begin(), sums.end(), result.row(0));
+        return result;
+    }
+
+    // Norm of every row, as a column.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto row_norms(const SimpleMatrix<T, ROW, COL, S> &m, Norm const norm = Norm::L2, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("row_norms", ROW, 1, COL, ROW * COL, ROW * COL * sizeof(T));
+        SimpleMatrix<detail::real_t<A>, ROW, 1> result;
+        detail::for_each_row<ROW, COL>([&](size_t r)
+                                       {
+                                           A const v = norm == Norm::Inf
+                                                           ? detail::max_magnitude<A>(m.row(r), COL)
+                                                           : detail::reduce_span<A>(m.row(r), COL, how, detail::norm_term<A>(norm)).value();
+                                           result.row(r)[0] = detail::finish_norm(v, norm); });
+        return result;
+    }
+
+    // Norm of every column, as a row.
+    template <class Acc = void, class T, size_t ROW, size_t COL, class S>
+    auto col_norms(const SimpleMatrix<T, ROW, COL, S> &m, Norm const norm = Norm::L2, Summation const how = Summation::Plain)
+    {
+        using A = detail::sum_t<Acc, T>;
+        MATRIX_INSTRUMENT_SCOPE("col_norms", 1, COL, ROW, ROW * COL, ROW * COL * sizeof(T));
+        SimpleMatrix<detail::real_t<A>, 1, COL> result;
+        std::vector<A> const sums = norm == Norm::Inf
+                                        ? detail::max_magnitude_columns<A, ROW, COL>(m)
+                                        : detail::reduce_columns<A, ROW, COL>(how, [&](size_t r, A *dst)
+                                                                              { detail::load_row(m, r, dst, detail::norm_term<A>(norm)); });
+        for (size_t c{0}; c < COL; c++)
+        {
+            result[0][c] = detail::finish_norm(sums[c], norm);
+        }
+        return result;
+    }
+
+    // Smallest element of every row and its column.
+    template <class T, size_t ROW, size_t COL, class S>
+    Extrema<T, ROW, 1> row_argmin(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("row_argmin", ROW, 1, COL, ROW * COL, ROW * COL * sizeof(T));
+        return detail::extremum_rows<false>(m);
+    }
+
+    // Largest element of every row and its column.
+    template <class T, size_t ROW, size_t COL, class S>
+    Extrema<T, ROW, 1> row_argmax(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("row_argmax", ROW, 1, COL, ROW * COL, ROW * COL * sizeof(T));
+        return detail::extremum_rows<true>(m);
+    }
+
+    // Smallest element of every column and its row.
+    template <class T, size_t ROW, size_t COL, class S>
+    Extrema<T, 1, COL> col_argmin(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("col_argmin", 1, COL, ROW, ROW * COL, ROW * COL * sizeof(T));
+        return detail::extremum_cols<false>(m);
+    }
+
+    // Largest element of every column and its row.
+    template <class T, size_t ROW, size_t COL, class S>
+    Extrema<T, 1, COL> col_argmax(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("col_argmax", 1, COL, ROW, ROW * COL, ROW * COL * sizeof(T));
+        return detail::extremum_cols<true>(m);
+    }
+
+} // namespace matrix
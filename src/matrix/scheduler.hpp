@@ -0,0 +1,462 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    namespace detail
+    {
+
+        // Task: A unit of work that lives in the stack frame of the fork that created it.
+        struct Task
+        {
+            void (*run)(Task &){nullptr};
+            std::atomic<bool> done{false};
+            std::exception_ptr error;
+
+            // Run the task, record any exception and publish completion.
+            void execute()
+            {
+                try
+                {
+                    run(*this);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                done.store(true, std::memory_order_release);
+            }
+        };
+
+        // Task that calls a function object held by reference.
+        template <class F>
+        struct TaskFor : Task
+        {
+            F &fn;
+
+            explicit TaskFor(F &f) : fn(f)
+            {
+                run = [](Task &t)
+                { static_cast<TaskFor &>(t).fn(); };
+            }
+        };
+
+        // WorkDeque: Chase-Lev work-stealing deque. The owning thread pushes and pops at the bottom
+        // without locks; any other thread steals from the top with a single CAS. The ring grows when
+        // full and retired rings stay alive until the deque is destroyed, since a thief may still read one.
+        class WorkDeque
+        {
+            struct Ring
+            {
+                int64_t capacity;
+                std::unique_ptr<std::atomic<Task *>[]> slots;
+
+                explicit Ring(int64_t c) : capacity(c), slots(new std::atomic<Task *>[size_t(c)]) {}
+
+                Task *get(int64_t const i) const
+                {
+                    return slots[size_t(i & (capacity - 1))].load(std::memory_order_relaxed);
+                }
+
+                void put(int64_t const i, Task *t)
+                {
+                    slots[size_t(i & (capacity - 1))].store(t, std::memory_order_relaxed);
+                }
+            };
+
+            std::atomic<int64_t> top_{0};
+            std::atomic<int64_t> bottom_{0};
+            std::atomic<Ring *> ring_;
+            std::vector<std::unique_ptr<Ring>> rings_; // Owner only.
+
+        public:
+            explicit WorkDeque(int64_t capacity = 64)
+            {
+                rings_.push_back(std::make_unique<Ring>(capacity));
+                ring_.store(rings_.back().get());
+            }
+
+            WorkDeque(const WorkDeque &) = delete;
+            WorkDeque &operator=(const WorkDeque &) = delete;
+
+            // Owner: push a task at the bottom.
+            void push(Task *t)
+            {
+                int64_t const b = bottom_.load(std::memory_order_relaxed);
+                int64_t const top = top_.load();
+                Ring *r = ring_.load(std::memory_order_relaxed);
+                if (b - top >= r->capacity)
+                {
+                    auto bigger = std::make_unique<Ring>(r->capacity * 2);
+                    for (int64_t i{top}; i < b; i++)
+                    {
+                        bigger->put(i, r->get(i));
+                    }
+                    r = bigger.get();
+                    rings_.push_back(std::move(bigger));
+                    ring_.store(r);
+                }
+                r->put(b, t);
+                bottom_.store(b + 1);
+            }
+
+            // Owner: pop the most recently pushed task, or nullptr if thieves took everything.
+            Task *pop()
+            {
+                int64_t const b = bottom_.load(std::memory_order_relaxed) - 1;
+                Ring *r = ring_.load(std::memory_order_relaxed);
+                bottom_.store(b);
+                int64_t t = top_.load();
+                if (t > b)
+                {
+                    bottom_.store(b + 1);
+                    return nullptr;
+                }
+                Task *x = r->get(b);
+                if (t == b)
+                {
+                    // Last element: race the thieves for it.
+                    if (!top_.compare_exchange_strong(t, t + 1))
+                    {
+                        x = nullptr;
+                    }
+                    bottom_.store(b + 1);
+                }
+                return x;
+            }
+
+            // Any thread: take the oldest task, or nullptr if the deque is empty or the race was lost.
+            Task *steal()
+            {
+                int64_t t = top_.load();
+                int64_t const b = bottom_.load();
+                if (t >= b)
+                {
+                    return nullptr;
+                }
+                Task *x = ring_.load()->get(t);
+                if (!top_.compare_exchange_strong(t, t + 1))
+                {
+                    return nullptr;
+                }
+                return x;
+            }
+
+            bool empty() const
+            {
+                return top_.load() >= bottom_.load();
+            }
+        };
+
+    } // namespace detail
+
+    // TaskScheduler: Work-stealing runtime for recursive kernels. Every thread owns a deque; fork_join
+    // pushes its second branch there, runs the first branch itself and, if the second was stolen, keeps
+    // stealing other work until the thief finishes it. Slot 0 belongs to an outside thread that enters
+    // the scheduler, so the caller takes part like it does in ThreadPool. Outside threads enter through
+    // the same admission lock as ThreadPool jobs, so the scheduler and the pool never run at once.
+    class TaskScheduler
+    {
+        struct Binding
+        {
+            TaskScheduler *scheduler{nullptr};
+            size_t slot{0};
+        };
+
+        std::vector<std::unique_ptr<detail::WorkDeque>> deques_;
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        size_t epoch_{0}; // Bumped under mutex_ whenever sleepers must re-check for work.
+        std::atomic<size_t> sleeping_{0};
+        std::atomic<bool> stop_{false};
+
+        static Binding &binding()
+        {
+            thread_local Binding b;
+            return b;
+        }
+
+        static uint32_t next_random()
+        {
+            thread_local uint32_t x = uint32_t(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return x;
+        }
+
+        // Steal one task from any deque but our own, starting at a random victim.
+        detail::Task *steal(size_t const self)
+        {
+            size_t const n = deques_.size();
+            size_t const start = next_random() % n;
+            for (size_t i{0}; i < n; i++)
+            {
+                size_t const victim = (start + i) % n;
+                if (victim == self)
+                {
+                    continue;
+                }
+                if (detail::Task *t = deques_[victim]->steal())
+                {
+                    return t;
+                }
+            }
+            return nullptr;
+        }
+
+        bool has_work() const
+        {
+            return std::any_of(deques_.begin(), deques_.end(), [](const auto &d)
+                               { return !d->empty(); });
+        }
+
+        void notify()
+        {
+            if (sleeping_.load() > 0)
+            {
+                std::lock_guard lock(mutex_);
+                ++epoch_;
+                wake_.notify_one();
+            }
+        }
+
+        // Park until new work is pushed. sleeping_ is raised before the last look at the deques, so a
+        // concurrent push either is seen here or sees the sleeper and bumps the epoch.
+        void sleep()
+        {
+            std::unique_lock lock(mutex_);
+            sleeping_.fetch_add(1);
+            size_t const seen = epoch_;
+            if (!stop_.load() && !has_work())
+            {
+                wake_.wait(lock, [&]
+                           { return stop_.load() || epoch_ != seen; });
+            }
+            sleeping_.fetch_sub(1);
+        }
+
+        void work(size_t const self, bool const pin)
+        {
+            binding() = {this, self};
+            detail::inside_parallel_region() = true;
+            detail::pin_worker(self, pin);
+            while (!stop_.load())
+            {
+                // The own deque is empty here: everything a task forks is joined before it returns.
+                detail::Task *t{nullptr};
+                for (size_t attempt{0}; attempt < 64 && !t; attempt++)
+                {
+                    t = steal(self);
+                    if (!t)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                if (t)
+                {
+                    t->execute();
+                }
+                else
+                {
+                    sleep();
+                }
+            }
+        }
+
+        // Run f() then g(), always both, and rethrow the first exception.
+        template <class F, class G>
+        static void run_serial(F &f, G &g)
+        {
+            std::exception_ptr error;
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            try
+            {
+                g();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        template <class F, class G>
+        void fork_join_at(size_t const self, F &f, G &g)
+        {
+            detail::TaskFor<G> child(g);
+            auto &deque = *deques_[self];
+            deque.push(&child);
+            notify();
+
+            std::exception_ptr error;
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            // Everything f forked has been joined, so the bottom of the deque is the child unless it was stolen.
+            if (deque.pop() == &child)
+            {
+                try
+                {
+                    g();
+                }
+                catch (...)
+                {
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+                return;
+            }
+
+            while (!child.done.load(std::memory_order_acquire))
+            {
+                if (detail::Task *t = steal(self))
+                {
+                    t->execute();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            if (!error)
+            {
+                error = child.error;
+            }
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+    public:
+        // Constructor: Start `threads - 1` workers; slot 0 is kept for the calling thread. With `pin`,
+        // workers are pinned like those of ThreadPool.
+        explicit TaskScheduler(size_t threads = std::max(1u, std::thread::hardware_concurrency()), bool const pin = pin_threads)
+        {
+            threads = std::max<size_t>(1, threads);
+            for (size_t i{0}; i < threads; i++)
+            {
+                deques_.push_back(std::make_unique<detail::WorkDeque>());
+            }
+            for (size_t i{1}; i < threads; i++)
+            {
+                workers_.emplace_back([this, i, pin]
+                                      { work(i, pin); });
+            }
+        }
+
+        TaskScheduler(const TaskScheduler &) = delete;
+        TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+        ~TaskScheduler()
+        {
+            {
+                std::lock_guard lock(mutex_);
+                stop_.store(true);
+                ++epoch_;
+            }
+            wake_.notify_all();
+            for (auto &w : workers_)
+            {
+                w.join();
+            }
+        }
+
+        // Process-wide scheduler used by the recursive kernels.
+        static TaskScheduler &instance()
+        {
+            static TaskScheduler scheduler;
+            return scheduler;
+        }
+
+        // Number of threads taking part, including the caller.
+        size_t size() const
+        {
+            return deques_.size();
+        }
+
+        // Run f() and g() potentially in parallel and return when both are done. Both branches always
+        // run to completion; the first exception, f's before g's, is rethrown afterwards. Called from a thread that is busy in another
+        // parallel region, both run serially; an outside thread waits its turn for the admission lock.
+        template <class F, class G>
+        void fork_join(F &&f, G &&g)
+        {
+            Binding const b = binding();
+            if (b.scheduler == this)
+            {
+                fork_join_at(b.slot, f, g);
+                return;
+            }
+
+            if (workers_.empty() || detail::inside_parallel_region())
+            {
+                run_serial(f, g);
+                return;
+            }
+
+            std::lock_guard lock(detail::admission());
+            struct Enter
+            {
+                Binding saved;
+                explicit Enter(TaskScheduler *s) : saved(binding())
+                {
+                    binding() = {s, 0};
+                    detail::inside_parallel_region() = true;
+                }
+                ~Enter()
+                {
+                    detail::inside_parallel_region() = false;
+                    binding() = saved;
+                }
+            } enter(this);
+            fork_join_at(0, f, g);
+        }
+    }; // TaskScheduler
+
+    // Run f() and g() in parallel on the process-wide work-stealing scheduler.
+    template <class F, class G>
+    void fork_join(F &&f, G &&g)
+    {
+        TaskScheduler::instance().fork_join(std::forward<F>(f), std::forward<G>(g));
+    }
+
+} // namespace matrix
@@ -0,0 +1,617 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "instrument.hpp"
+#include "numa.hpp"
+#include "parallel.hpp"
+
+// Default byte alignment of matrix storage; one cache line and one AVX-512 register.
+#ifndef MATRIX_ALIGNMENT
+#define MATRIX_ALIGNMENT 64
+#endif
+
+// Largest Dense matrix, in bytes, whose elements are stored inside the object.
+#ifndef MATRIX_INLINE_BYTES
+#define MATRIX_INLINE_BYTES 512
+#endif
+
+namespace matrix
+{
+
+    inline constexpr size_t default_alignment = MATRIX_ALIGNMENT;
+
+    // Cache line size used to pick padded strides.
+    inline constexpr size_t cache_line = 64;
+
+    // Dense matrices up to this many bytes keep their elements inline instead of on the heap.
+    inline constexpr size_t inline_storage_bytes = MATRIX_INLINE_BYTES;
+
+    // AllocationStats: Number and total size of storage allocations.
+    struct AllocationStats
+    {
+        uint64_t calls{0};
+        uint64_t bytes{0};
+    };
+
+    namespace detail
+    {
+
+        inline AllocationStats &thread_allocations()
+        {
+            thread_local AllocationStats stats;
+            return stats;
+        }
+
+    } // namespace detail
+
+    // Storage allocations made so far by the calling thread.
+    inline AllocationStats allocation_stats()
+    {
+        return detail::thread_allocations();
+    }
+
+    // AllocationCounter: Counts the storage allocations the calling thread makes after construction.
+    class AllocationCounter
+    {
+        AllocationStats start_;
+
+    public:
+        AllocationCounter() : start_(allocation_stats()) {}
+
+        uint64_t calls() const
+        {
+            return allocation_stats().calls - start_.calls;
+        }
+
+        uint64_t bytes() const
+        {
+            return allocation_stats().bytes - start_.bytes;
+        }
+    };
+
+    // AlignedAllocator: Standard allocator returning memory aligned to ALIGN bytes. Allocations of at least
+    // numa_allocation_bytes get the current NUMA policy.
+    template <class T, size_t ALIGN = default_alignment>
+    struct AlignedAllocator
+    {
+        static_assert((ALIGN & (ALIGN - 1)) == 0, "Alignment must be a power of two.");
+
+        using value_type = T;
+
+        static constexpr std::align_val_t alignment{std::max(ALIGN, alignof(T))};
+
+        template <class U>
+        struct rebind
+        {
+            using other = AlignedAllocator<U, ALIGN>;
+        };
+
+        AlignedAllocator() = default;
+
+        template <class U>
+        AlignedAllocator(const AlignedAllocator<U, ALIGN> &) noexcept {}
+
+        T *allocate(size_t const n)
+        {
+            auto &stats = detail::thread_allocations();
+            stats.calls++;
+            stats.bytes += n * sizeof(T);
+            MATRIX_INSTRUMENT_ALLOCATION(n * sizeof(T));
+            T *p = static_cast<T *>(::operator new(n * sizeof(T), alignment));
+            if (n * sizeof(T) >= numa_allocation_bytes)
+            {
+                detail::apply_numa_policy(p, n * sizeof(T));
+            }
+            return p;
+        }
+
+        void deallocate(T *p, size_t const n) noexcept
+        {
+            if (n * sizeof(T) >= numa_allocation_bytes)
+            {
+                detail::release_numa_policy(p, n * sizeof(T));
+            }
+            ::operator delete(p, n * sizeof(T), alignment);
+        }
+
+        friend bool operator==(const AlignedAllocator &, const AlignedAllocator &)
+        {
+            return true;
+        }
+    };
+
+    namespace detail
+    {
+
+        // Call f(lo, hi) on row blocks of a ROW x STRIDE buffer, in parallel by the same row blocks the
+        // kernels split their results into, so each page is first touched by the thread that later works on it.
+        template <size_t ROW, size_t STRIDE, class F>
+        void for_each_row_block(F &&f)
+        {
+            if (ROW * STRIDE < parallel_threshold)
+            {
+                f(size_t{0}, ROW);
+                return;
+            }
+            parallel_for(0, ROW, std::max<size_t>(1, parallel_threshold / STRIDE), f);
+        }
+
+        // Heap storage of ROW rows STRIDE elements apart in one ALIGN-aligned allocation. Large buffers
+        // of trivially copyable elements are zeroed and copied in parallel row blocks (see for_each_row_block).
+        template <class T, size_t ROW, size_t COL, size_t STRIDE, size_t ALIGN>
+        class HeapStorage
+        {
+            using allocator = AlignedAllocator<T, ALIGN>;
+            static constexpr size_t size = ROW * STRIDE;
+            static constexpr bool trivial = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
+
+            T *data_{nullptr};
+
+            // Fill a fresh buffer with `init(dst, lo, hi)` for row blocks [lo, hi).
+            template <class F>
+            void construct(F &&init)
+            {
+                data_ = allocator().allocate(size);
+                if constexpr (trivial)
+                {
+                    for_each_row_block<ROW, STRIDE>([&](size_t lo, size_t hi)
+                                                    { init(data_, lo, hi); });
+                }
+                else
+                {
+                    try
+                    {
+                        init(data_, 0, ROW);
+                    }
+                    catch (...)
+                    {
+                        allocator().deallocate(data_, size);
+                        throw;
+                    }
+                }
+            }
+
+            void release() noexcept
+            {
+                if (data_ != nullptr)
+                {
+                    std::destroy_n(data_, size);
+                    allocator().deallocate(data_, size);
+                    data_ = nullptr;
+                }
+            }
+
+        public:
+            static constexpr size_t alignment = ALIGN;
+            static constexpr bool aligned_rows = (STRIDE * sizeof(T)) % ALIGN == 0;
+
+            HeapStorage()
+            {
+                construct([](T *dst, size_t lo, size_t hi)
+                          { std::uninitialized_value_construct(dst + lo * STRIDE, dst + hi * STRIDE); });
+            }
+
+            HeapStorage(const HeapStorage &other)
+            {
+                if (other.data_ == nullptr)
+                {
+                    return; // Copy of a moved-from matrix.
+                }
+                construct([&](T *dst, size_t lo, size_t hi)
+                          { std::uninitialized_copy(other.data_ + lo * STRIDE, other.data_ + hi * STRIDE, dst + lo * STRIDE); });
+            }
+
+            HeapStorage(HeapStorage &&other) noexcept : data_(std::exchange(other.data_, nullptr)) {}
+
+            // Copy ROW rows of COL elements, STRIDE apart, from src; the padding is value-initialized and
+            // never read from src.
+            explicit HeapStorage(const T *src)
+            {
+                construct([&](T *dst, size_t lo, size_t hi)
+                          {
+                              if constexpr (STRIDE == COL)
+                              {
+                                  std::uninitialized_copy(src + lo * STRIDE, src + hi * STRIDE, dst + lo * STRIDE);
+                              }
+                              else
+                              {
+                                  std::uninitialized_value_construct(dst + lo * STRIDE, dst + hi * STRIDE);
+                                  for (size_t r{lo}; r < hi; r++)
+                                  {
+                                      std::copy(src + r * STRIDE, src + r * STRIDE + COL, dst + r * STRIDE);
+                                  }
+                              } });
+            }
+
+            // Copying into a live buffer reuses it instead of allocating.
+            HeapStorage &operator=(const HeapStorage &other)
+            {
+                if (this == &other)
+                {
+                    return *this;
+                }
+                if (data_ == nullptr || other.data_ == nullptr)
+                {
+                    HeapStorage copy(other);
+                    std::swap(data_, copy.data_);
+                    return *this;
+                }
+                if constexpr (trivial)
+                {
+                    for_each_row_block<ROW, STRIDE>([&](size_t lo, size_t hi)
+                                                    { std::copy(other.data_ + lo * STRIDE, other.data_ + hi * STRIDE, data_ + lo * STRIDE); });
+                }
+                else
+                {
+                    std::copy(other.data_, other.data_ + size, data_);
+                }
+                return *this;
+            }
+
+            HeapStorage &operator=(HeapStorage &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    data_ = std::exchange(other.data_, nullptr);
+                }
+                return *this;
+            }
+
+            ~HeapStorage()
+            {
+                release();
+            }
+
+            static constexpr size_t stride()
+            {
+                return STRIDE;
+            }
+
+            T *data()
+            {
+                return data_;
+            }
+
+            const T *data() const
+            {
+                return data_;
+            }
+        };
+
+        // Storage kept inside the matrix object itself; copies and moves never allocate.
+        template <class T, size_t ROW, size_t COL, size_t ALIGN>
+        class InlineStorage
+        {
+            alignas(ALIGN) std::array<T, ROW * COL> data_{};
+
+        public:
+            static constexpr size_t alignment = ALIGN;
+            static constexpr bool aligned_rows = (COL * sizeof(T)) % ALIGN == 0;
+
+            static constexpr size_t stride()
+            {
+                return COL;
+            }
+
+            T *data()
+            {
+                return data_.data();
+            }
+
+            const T *data() const
+            {
+                return data_.data();
+            }
+        };
+
+        // Heap storage shared between copies: copying takes a reference, and the first mutable access
+        // to a buffer that other matrices still reference copies it (detaches). The reference count is
+        // atomic, so copies may be read and detached on different threads; one matrix must not detach
+        // on two threads at once, so parallel kernels take data() before they split the work.
+        template <class T, size_t ROW, size_t COL, size_t STRIDE, size_t ALIGN>
+        class SharedStorage
+        {
+            using heap = HeapStorage<T, ROW, COL, STRIDE, ALIGN>;
+
+            struct Block
+            {
+                std::atomic<size_t> refs{1};
+                heap storage;
+
+                Block() = default;
+
+                explicit Block(const heap &other) : storage(other) {}
+            };
+
+            Block *block_{nullptr};
+
+            void release() noexcept
+            {
+                if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    delete block_;
+                }
+                block_ = nullptr;
+            }
+
+        public:
+            static constexpr size_t alignment = heap::alignment;
+            static constexpr bool aligned_rows = heap::aligned_rows;
+
+            SharedStorage() : block_(new Block) {}
+
+            SharedStorage(const SharedStorage &other) noexcept : block_(other.block_)
+            {
+                if (block_ != nullptr)
+                {
+                    block_->refs.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            SharedStorage(SharedStorage &&other) noexcept : block_(std::exchange(other.block_, nullptr)) {}
+
+            SharedStorage &operator=(const SharedStorage &other) noexcept
+            {
+                SharedStorage copy(other);
+                std::swap(block_, copy.block_);
+                return *this;
+            }
+
+            SharedStorage &operator=(SharedStorage &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    block_ = std::exchange(other.block_, nullptr);
+                }
+                return *this;
+            }
+
+            ~SharedStorage()
+            {
+                release();
+            }
+
+            static constexpr size_t stride()
+            {
+                return STRIDE;
+            }
+
+            // Mutable access: detach first if the buffer is shared. The acquire load orders this
+            // thread's writes after the last reader that let go of the buffer.
+            T *data()
+            {
+                if (block_ == nullptr)
+                {
+                    return nullptr;
+                }
+                if (block_->refs.load(std::memory_order_acquire) != 1)
+                {
+                    auto *copy = new Block(block_->storage);
+                    release();
+                    block_ = copy;
+                }
+                return block_->storage.data();
+            }
+
+            const T *data() const
+            {
+                return block_ == nullptr ? nullptr : std::as_const(block_->storage).data();
+            }
+        };
+
+        // Storage in a buffer the matrix did not allocate: a view that never frees it, or an adopted
+        // buffer released by a custom deleter. A default-constructed matrix and every copy own a fresh
+        // heap buffer instead, so copies never alias the external memory and functions that take a
+        // matrix by value cannot write to it. Assignment copies elements into the current buffer, so a
+        // view keeps referring to the same memory for its whole life.
+        template <class T, size_t ROW, size_t COL, size_t STRIDE>
+        class ExternalStorage
+        {
+            static_assert(STRIDE >= COL, "Rows must not overlap.");
+
+            using heap = HeapStorage<T, ROW, COL, STRIDE, default_alignment>;
+
+            T *data_{nullptr};
+            std::function<void(T *)> release_; // Empty for a view.
+
+            void own(heap *buffer)
+            {
+                data_ = buffer->data();
+                release_ = [buffer](T *)
+                { delete buffer; };
+            }
+
+            void copy_from(const T *src)
+            {
+                for (size_t r{0}; r < ROW; r++)
+                {
+                    std::copy(src + r * STRIDE, src + r * STRIDE + COL, data_ + r * STRIDE);
+                }
+            }
+
+            void release() noexcept
+            {
+                if (release_)
+                {
+                    release_(data_);
+                }
+                data_ = nullptr;
+                release_ = nullptr;
+            }
+
+        public:
+            static constexpr size_t alignment = alignof(T);
+            static constexpr bool aligned_rows = false;
+
+            // Elements from the first element of row 0 to the last element of the last row.
+            static constexpr size_t extent = ROW == 0 ? 0 : (ROW - 1) * STRIDE + COL;
+
+            ExternalStorage()
+            {
+                own(new heap());
+            }
+
+            // View of `data`, which must outlive the matrix.
+            explicit ExternalStorage(T *data) : data_(data) {}
+
+            // Adopt `data`: release(data) is called when the matrix is destroyed.
+            ExternalStorage(T *data, std::function<void(T *)> release) : data_(data), release_(std::move(release)) {}
+
+            ExternalStorage(const ExternalStorage &other)
+            {
+                if (other.data_ != nullptr)
+                {
+                    own(new heap(other.data_));
+                }
+            }
+
+            ExternalStorage(ExternalStorage &&other) noexcept
+                : data_(std::exchange(other.data_, nullptr)), release_(std::exchange(other.release_, nullptr)) {}
+
+            ExternalStorage &operator=(const ExternalStorage &other)
+            {
+                if (this == &other)
+                {
+                    return *this;
+                }
+                if (data_ == nullptr)
+                {
+                    ExternalStorage copy(other);
+                    std::swap(data_, copy.data_);
+                    std::swap(release_, copy.release_);
+                    return *this;
+                }
+                if (other.data_ != nullptr)
+                {
+                    copy_from(other.data_);
+                }
+                return *this;
+            }
+
+            // Moving into a matrix that has a buffer copies the elements, as assignment does.
+            ExternalStorage &operator=(ExternalStorage &&other) noexcept
+            {
+                if (this == &other)
+                {
+                    return *this;
+                }
+                if (data_ == nullptr)
+                {
+                    data_ = std::exchange(other.data_, nullptr);
+                    release_ = std::exchange(other.release_, nullptr);
+                }
+                else if (other.data_ != nullptr)
+                {
+                    copy_from(other.data_);
+                }
+                return *this;
+            }
+
+            ~ExternalStorage()
+            {
+                release();
+            }
+
+            static constexpr size_t stride()
+            {
+                return STRIDE;
+            }
+
+            T *data()
+            {
+                return data_;
+            }
+
+            const T *data() const
+            {
+                return data_;
+            }
+        };
+
+    } // namespace detail
+
+    // Dense: Storage policy that keeps rows back to back (stride == COL) in one ALIGN-aligned block.
+    // Matrices of at most inline_storage_bytes hold their elements inline and never allocate.
+    template <size_t ALIGN = default_alignment>
+    struct Dense
+    {
+        using result_layout = Dense;
+
+        template <class T, size_t ROW, size_t COL>
+        using storage = std::conditional_t<ROW * COL * sizeof(T) <= inline_storage_bytes,
+                                           detail::InlineStorage<T, ROW, COL, ALIGN>,
+                                           detail::HeapStorage<T, ROW, COL, COL, ALIGN>>;
+    };
+
+    // Row stride of a Padded matrix: whole ALIGN units per row and, once a row spans four or more cache
+    // lines, an odd number of lines, so walking down a column cycles through every cache set instead of
+    // aliasing on power-of-two strides.
+    template <class T, size_t COL, size_t ALIGN>
+    constexpr size_t padded_stride()
+    {
+        size_t const unit = std::max(ALIGN, cache_line);
+        size_t bytes = (COL * sizeof(T) + ALIGN - 1) / ALIGN * ALIGN;
+        if (bytes % sizeof(T) != 0)
+        {
+            return COL; // Element size does not divide the alignment; padding cannot help.
+        }
+        if (bytes >= 4 * cache_line && (bytes / unit) % 2 == 0)
+        {
+            bytes += unit;
+        }
+        return bytes / sizeof(T);
+    }
+
+    // Padded: Storage policy that starts every row on an ALIGN boundary with a conflict-free stride.
+    template <size_t ALIGN = default_alignment>
+    struct Padded
+    {
+        using result_layout = Padded;
+
+        template <class T, size_t ROW, size_t COL>
+        using storage = detail::HeapStorage<T, ROW, COL, padded_stride<T, COL, ALIGN>(), ALIGN>;
+    };
+
+    // Shared: Storage policy that keeps rows back to back on the heap and shares the buffer between
+    // copies until one of them is modified (copy-on-write). Copies are O(1) and allocation free;
+    // mutable access (data(), row(), operator[], begin()) detaches a shared buffer first. Pointers
+    // taken from a matrix must not be written through after it has been copied.
+    template <size_t ALIGN = default_alignment>
+    struct Shared
+    {
+        using result_layout = Shared;
+
+        template <class T, size_t ROW, size_t COL>
+        using storage = detail::SharedStorage<T, ROW, COL, COL, ALIGN>;
+    };
+
+    // External: Storage policy for buffers owned outside the library, with rows STRIDE elements apart
+    // (0 meaning COL). Matrices are made with view() or adopt(); operations on them return Dense matrices.
+    template <size_t STRIDE = 0>
+    struct External
+    {
+        using result_layout = Dense<>;
+
+        template <class T, size_t ROW, size_t COL>
+        using storage = detail::ExternalStorage<T, ROW, COL, STRIDE == 0 ? COL : STRIDE>;
+    };
+
+    // Layout of matrices produced from operands with layout S.
+    template <class S>
+    using result_layout_t = typename S::result_layout;
+
+} // namespace matrix
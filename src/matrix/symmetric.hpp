@@ -0,0 +1,413 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include "matrix.hpp"
+#include "kernels.hpp"
+#include "parallel.hpp"
+
+namespace matrix
+{
+
+    // Triangle of a matrix that is kept in packed storage.
+    enum class Triangle
+    {
+        Upper,
+        Lower
+    };
+
+    // Number of columns factored per step of the blocked Cholesky factorization.
+    inline constexpr size_t cholesky_block_size = 64;
+
+    // not_positive_definite: Thrown by the Cholesky routines when a pivot is not positive.
+    class not_positive_definite : public std::domain_error
+    {
+        size_t column_;
+
+    public:
+        explicit not_positive_definite(size_t column)
+            : std::domain_error("Matrix is not positive definite (pivot " + std::to_string(column) + ")"),
+              column_(column)
+        {
+        }
+
+        // Index of the first leading minor that is not positive definite.
+        size_t column() const noexcept
+        {
+            return column_;
+        }
+    };
+
+    // SymmetricMatrix: An N x N symmetric matrix that stores one triangle row by row in N*(N+1)/2 elements.
+    template <typename T, size_t N, Triangle UPLO = Triangle::Lower>
+    class SymmetricMatrix
+    {
+        std::vector<T> data_;
+
+    public:
+        static constexpr size_t packed_size = N * (N + 1) / 2;
+
+        // Offset of element (r, c) in the packed array; (r, c) must lie in the stored triangle.
+        static constexpr size_t index(size_t const r, size_t const c)
+        {
+            if constexpr (UPLO == Triangle::Lower)
+            {
+                return r * (r + 1) / 2 + c;
+            }
+            else
+            {
+                return r * (2 * N - r + 1) / 2 + (c - r);
+            }
+        }
+
+        // Constructor: Initialize the matrix with default-initialized elements.
+        SymmetricMatrix() : data_(packed_size) {}
+
+        // Constructor: Initialize the stored triangle, row by row, from an initializer list.
+        explicit SymmetricMatrix(std::initializer_list<T> init_list) : data_(init_list)
+        {
+            if (init_list.size() != packed_size)
+            {
+                throw std::invalid_argument("Invalid initializer list size");
+            }
+        }
+
+        // Constructor: Take the stored triangle of a dense matrix; the other triangle is ignored.
+        template <class S>
+        explicit SymmetricMatrix(const SimpleMatrix<T, N, N, S> &m) : data_(packed_size)
+        {
+            for (size_t i{0}; i < N; i++)
+            {
+                const T *src = m.row(i);
+                if constexpr (UPLO == Triangle::Lower)
+                {
+                    std::copy(src, src + i + 1, row(i));
+                }
+                else
+                {
+                    std::copy(src + i, src + N, row(i));
+                }
+            }
+        }
+
+        // Access an element at a specific row and column; either triangle may be addressed.
+        constexpr T const &at(size_t r, size_t c) const
+        {
+            if (r >= N || c >= N)
+            {
+                throw std::out_of_range("r >= N || c >= N");
+            }
+            if ((UPLO == Triangle::Lower) == (c > r))
+            {
+                std::swap(r, c);
+            }
+            return data_[index(r, c)];
+        }
+
+        // Mutable access; writing (r, c) also changes (c, r).
+        constexpr T &at(size_t const r, size_t const c)
+        {
+            return const_cast<T &>(std::as_const(*this).at(r, c));
+        }
+
+        // Stored part of row r: columns [0, r] for Lower, [r, N) for Upper.
+        T *row(size_t const r)
+        {
+            return data_.data() + index(r, UPLO == Triangle::Lower ? 0 : r);
+        }
+
+        const T *row(size_t const r) const
+        {
+            return data_.data() + index(r, UPLO == Triangle::Lower ? 0 : r);
+        }
+
+        // Pointer to the packed storage.
+        T *data()
+        {
+            return data_.data();
+        }
+
+        const T *data() const
+        {
+            return data_.data();
+        }
+
+        // Expand into a dense matrix with both triangles filled.
+        SimpleMatrix<T, N, N> dense() const
+        {
+            SimpleMatrix<T, N, N> result;
+            for (size_t i{0}; i < N; i++)
+            {
+                T *out = result.row(i);
+                for (size_t j{0}; j < N; j++)
+                {
+                    out[j] = at(i, j);
+                }
+            }
+            return result;
+        }
+
+        // Equality operator: compares the stored triangles.
+        friend bool operator==(const SymmetricMatrix &lhs, const SymmetricMatrix &rhs)
+        {
+            return lhs.data_ == rhs.data_;
+        }
+
+        // Output operator to display the full matrix.
+        friend std::ostream &operator<<(std::ostream &os, const SymmetricMatrix &m)
+        {
+            return os << m.dense();
+        }
+    }; // SymmetricMatrix
+
+    namespace detail
+    {
+
+        // Blocked right-looking A = L * L^T on lower packed rows. Each block factors its diagonal part
+        // serially, then solves the panel below it and updates the trailing triangle row-parallel.
+        template <class T, size_t N>
+        void cholesky_lower(SymmetricMatrix<T, N, Triangle::Lower> &a)
+        {
+            for (size_t k0{0}; k0 < N; k0 += cholesky_block_size)
+            {
+                size_t const k1 = std::min(N, k0 + cholesky_block_size);
+                size_t const nb = k1 - k0;
+
+                for (size_t i{k0}; i < k1; i++)
+                {
+                    T *li = a.row(i);
+                    for (size_t j{k0}; j < i; j++)
+                    {
+                        const T *lj = a.row(j);
+                        li[j] = (li[j] - dot(li + k0, lj + k0, j - k0)) / lj[j];
+                    }
+                    T const d = li[i] - dot(li + k0, li + k0, i - k0);
+                    if (!(d > T{0}))
+                    {
+                        throw not_positive_definite(i);
+                    }
+                    li[i] = std::sqrt(d);
+                }
+
+                size_t const grain = std::max<size_t>(1, parallel_threshold / (N * nb));
+
+                parallel_for(k1, N, grain, [&](size_t lo, size_t hi)
+                             {
+                                 for (size_t i{lo}; i < hi; i++)
+                                 {
+                                     T *li = a.row(i);
+                                     for (size_t j{k0}; j < k1; j++)
+                                     {
+                                         const T *lj = a.row(j);
+                                         li[j] = (li[j] - dot(li + k0, lj + k0, j - k0)) / lj[j];
+                                     }
+                                 } });
+
+                parallel_for(k1, N, grain, [&](size_t lo, size_t hi)
+                             {
+                                 for (size_t i{lo}; i < hi; i++)
+                                 {
+                                     T *li = a.row(i);
+                                     for (size_t j{k1}; j <= i; j++)
+                                     {
+                                         li[j] -= dot(li + k0, a.row(j) + k0, nb);
+                                     }
+                                 } });
+            }
+        }
+
+        // Blocked right-looking A = U^T * U on upper packed rows. Block rows are finished over the full
+        // width with row-contiguous axpys, then every trailing row subtracts the block's contribution.
+        template <class T, size_t N>
+        void cholesky_upper(SymmetricMatrix<T, N, Triangle::Upper> &a)
+        {
+            for (size_t k0{0}; k0 < N; k0 += cholesky_block_size)
+            {
+                size_t const k1 = std::min(N, k0 + cholesky_block_size);
+
+                for (size_t i{k0}; i < k1; i++)
+                {
+                    T *ui = a.row(i);
+                    if (!(ui[0] > T{0}))
+                    {
+                        throw not_positive_definite(i);
+                    }
+                    ui[0] = std::sqrt(ui[0]);
+                    T const inv = T{1} / ui[0];
+                    for (size_t j{1}; j < N - i; j++)
+                    {
+                        ui[j] *= inv;
+                    }
+                    for (size_t r{i + 1}; r < k1; r++)
+                    {
+                        axpy(-ui[r - i], ui + (r - i), a.row(r), N - r);
+                    }
+                }
+
+                size_t const grain = std::max<size_t>(1, parallel_threshold / (N * (k1 - k0)));
+
+                parallel_for(k1, N, grain, [&](size_t lo, size_t hi)
+                             {
+                                 for (size_t r{lo}; r < hi; r++)
+                                 {
+                                     T *ur = a.row(r);
+                                     for (size_t i{k0}; i < k1; i++)
+                                     {
+                                         const T *ui = a.row(i);
+                                         axpy(-ui[r - i], ui + (r - i), ur, N - r);
+                                     }
+                                 } });
+            }
+        }
+
+        // Solve L * Y = B over right-hand-side columns [c0, c1) of the row-major B (row stride ldb).
+        template <class T, size_t N>
+        void forward_lower(const SymmetricMatrix<T, N, Triangle::Lower> &l, T *b, size_t ldb, size_t c0, size_t c1)
+        {
+            for (size_t i{0}; i < N; i++)
+            {
+                const T *li = l.row(i);
+                T *bi = b + i * ldb;
+                for (size_t j{0}; j < i; j++)
+                {
+                    axpy(-li[j], b + j * ldb + c0, bi + c0, c1 - c0);
+                }
+                T const inv = T{1} / li[i];
+                for (size_t c{c0}; c < c1; c++)
+                {
+                    bi[c] *= inv;
+                }
+            }
+        }
+
+        // Solve L^T * X = Y over right-hand-side columns [c0, c1).
+        template <class T, size_t N>
+        void backward_lower(const SymmetricMatrix<T, N, Triangle::Lower> &l, T *b, size_t ldb, size_t c0, size_t c1)
+        {
+            for (size_t i{N}; i-- > 0;)
+            {
+                const T *li = l.row(i);
+                T *bi = b + i * ldb;
+                T const inv = T{1} / li[i];
+                for (size_t c{c0}; c < c1; c++)
+                {
+                    bi[c] *= inv;
+                }
+                for (size_t j{0}; j < i; j++)
+                {
+                    axpy(-li[j], bi + c0, b + j * ldb + c0, c1 - c0);
+                }
+            }
+        }
+
+        // Solve U^T * Y = B over right-hand-side columns [c0, c1).
+        template <class T, size_t N>
+        void forward_upper(const SymmetricMatrix<T, N, Triangle::Upper> &u, T *b, size_t ldb, size_t c0, size_t c1)
+        {
+            for (size_t i{0}; i < N; i++)
+            {
+                const T *ui = u.row(i);
+                T *bi = b + i * ldb;
+                T const inv = T{1} / ui[0];
+                for (size_t c{c0}; c < c1; c++)
+                {
+                    bi[c] *= inv;
+                }
+                for (size_t j{i + 1}; j < N; j++)
+                {
+                    axpy(-ui[j - i], bi + c0, b + j * ldb + c0, c1 - c0);
+                }
+            }
+        }
+
+        // Solve U * X = Y over right-hand-side columns [c0, c1).
+        template <class T, size_t N>
+        void backward_upper(const SymmetricMatrix<T, N, Triangle::Upper> &u, T *b, size_t ldb, size_t c0, size_t c1)
+        {
+            for (size_t i{N}; i-- > 0;)
+            {
+                const T *ui = u.row(i);
+                T *bi = b + i * ldb;
+                for (size_t j{i + 1}; j < N; j++)
+                {
+                    axpy(-ui[j - i], b + j * ldb + c0, bi + c0, c1 - c0);
+                }
+                T const inv = T{1} / ui[0];
+                for (size_t c{c0}; c < c1; c++)
+                {
+                    bi[c] *= inv;
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // Factor a symmetric positive definite matrix in place: A = L * L^T for Lower, A = U^T * U for Upper.
+    // Throws not_positive_definite as soon as a pivot fails; the diagonal is screened before any flops are spent.
+    template <class T, size_t N, Triangle UPLO>
+    void cholesky_inplace(SymmetricMatrix<T, N, UPLO> &a)
+    {
+        MATRIX_INSTRUMENT_SCOPE("cholesky", N, N, 0, N * N * N / 3, 2 * a.packed_size * sizeof(T));
+        for (size_t i{0}; i < N; i++)
+        {
+            T const d = a.row(i)[UPLO == Triangle::Lower ? i : 0];
+            if (!(d > T{0}))
+            {
+                throw not_positive_definite(i);
+            }
+        }
+
+        if constexpr (UPLO == Triangle::Lower)
+        {
+            detail::cholesky_lower(a);
+        }
+        else
+        {
+            detail::cholesky_upper(a);
+        }
+    }
+
+    // Return the Cholesky factor of a symmetric positive definite matrix, packed in the same triangle.
+    template <class T, size_t N, Triangle UPLO>
+    SymmetricMatrix<T, N, UPLO> cholesky(SymmetricMatrix<T, N, UPLO> a)
+    {
+        cholesky_inplace(a);
+        return a;
+    }
+
+    // Solve A * X = B given the factor of A returned by cholesky(). Right-hand-side columns are solved in parallel.
+    template <class T, size_t N, Triangle UPLO, size_t K, class S>
+    SimpleMatrix<T, N, K, result_layout_t<S>> cholesky_solve(const SymmetricMatrix<T, N, UPLO> &factor, const SimpleMatrix<T, N, K, S> &rhs)
+    {
+        SimpleMatrix<T, N, K, result_layout_t<S>> b(rhs);
+        MATRIX_INSTRUMENT_SCOPE("cholesky_solve", N, K, N, 2 * N * N * K, (factor.packed_size + 2 * N * K) * sizeof(T));
+        T *x = b.data();
+        size_t const ldb = b.stride();
+        size_t const grain = std::max<size_t>(1, parallel_threshold / (N * N));
+
+        parallel_for(0, K, grain, [&](size_t c0, size_t c1)
+                     {
+                         if constexpr (UPLO == Triangle::Lower)
+                         {
+                             detail::forward_lower(factor, x, ldb, c0, c1);
+                             detail::backward_lower(factor, x, ldb, c0, c1);
+                         }
+                         else
+                         {
+                             detail::forward_upper(factor, x, ldb, c0, c1);
+                             detail::backward_upper(factor, x, ldb, c0, c1);
+                         } });
+
+        return b;
+    }
+
+    // Solve the symmetric positive definite system A * X = B.
+    template <class T, size_t N, Triangle UPLO, size_t K, class S>
+    SimpleMatrix<T, N, K, result_layout_t<S>> solve_spd(SymmetricMatrix<T, N, UPLO> a, const SimpleMatrix<T, N, K, S> &b)
+    {
+        cholesky_inplace(a);
+        return cholesky_solve(a, b);
+    }
+
+} // namespace matrix
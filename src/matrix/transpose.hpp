@@ -0,0 +1,228 @@
+#pragma once
+
+#include <utility>
+
+#include "matrix.hpp"
+#include "scheduler.hpp"
+
+namespace matrix
+{
+
+    namespace detail
+    {
+
+        // Edge of the blocks at which the cache-oblivious recursion stops and the tile kernel takes over.
+        inline constexpr size_t transpose_leaf = 32;
+
+#if defined(__AVX__)
+        // Transpose one 8x8 tile of 4-byte elements held in eight AVX registers.
+        inline void transpose8x8(const float *src, size_t const ls, float *dst, size_t const ld)
+        {
+            __m256 const r0 = _mm256_loadu_ps(src + 0 * ls);
+            __m256 const r1 = _mm256_loadu_ps(src + 1 * ls);
+            __m256 const r2 = _mm256_loadu_ps(src + 2 * ls);
+            __m256 const r3 = _mm256_loadu_ps(src + 3 * ls);
+            __m256 const r4 = _mm256_loadu_ps(src + 4 * ls);
+            __m256 const r5 = _mm256_loadu_ps(src + 5 * ls);
+            __m256 const r6 = _mm256_loadu_ps(src + 6 * ls);
+            __m256 const r7 = _mm256_loadu_ps(src + 7 * ls);
+
+            __m256 const t0 = _mm256_unpacklo_ps(r0, r1);
+            __m256 const t1 = _mm256_unpackhi_ps(r0, r1);
+            __m256 const t2 = _mm256_unpacklo_ps(r2, r3);
+            __m256 const t3 = _mm256_unpackhi_ps(r2, r3);
+            __m256 const t4 = _mm256_unpacklo_ps(r4, r5);
+            __m256 const t5 = _mm256_unpackhi_ps(r4, r5);
+            __m256 const t6 = _mm256_unpacklo_ps(r6, r7);
+            __m256 const t7 = _mm256_unpackhi_ps(r6, r7);
+
+            __m256 const s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+            __m256 const s1 = _mm256_shuffle_ps(t0, t2, 0xee);
+            __m256 const s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+            __m256 const s3 = _mm256_shuffle_ps(t1, t3, 0xee);
+            __m256 const s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+            __m256 const s5 = _mm256_shuffle_ps(t4, t6, 0xee);
+            __m256 const s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+            __m256 const s7 = _mm256_shuffle_ps(t5, t7, 0xee);
+
+            _mm256_storeu_ps(dst + 0 * ld, _mm256_permute2f128_ps(s0, s4, 0x20));
+            _mm256_storeu_ps(dst + 1 * ld, _mm256_permute2f128_ps(s1, s5, 0x20));
+            _mm256_storeu_ps(dst + 2 * ld, _mm256_permute2f128_ps(s2, s6, 0x20));
+            _mm256_storeu_ps(dst + 3 * ld, _mm256_permute2f128_ps(s3, s7, 0x20));
+            _mm256_storeu_ps(dst + 4 * ld, _mm256_permute2f128_ps(s0, s4, 0x31));
+            _mm256_storeu_ps(dst + 5 * ld, _mm256_permute2f128_ps(s1, s5, 0x31));
+            _mm256_storeu_ps(dst + 6 * ld, _mm256_permute2f128_ps(s2, s6, 0x31));
+            _mm256_storeu_ps(dst + 7 * ld, _mm256_permute2f128_ps(s3, s7, 0x31));
+        }
+#endif
+
+        // dst[j][i] = src[i][j] for a leaf block. 4-byte trivially copyable elements go through the
+        // 8x8 register kernel when AVX is available; edges and other types use the scalar loop.
+        template <class T>
+        void transpose_leaf_block(const T *src, size_t const ls, T *dst, size_t const ld, size_t const rows, size_t const cols)
+        {
+            size_t i0{0};
+#if defined(__AVX__)
+            if constexpr (sizeof(T) == 4 && std::is_trivially_copyable_v<T>)
+            {
+                for (; i0 + 8 <= rows; i0 += 8)
+                {
+                    size_t j0{0};
+                    for (; j0 + 8 <= cols; j0 += 8)
+                    {
+                        transpose8x8(reinterpret_cast<const float *>(src + i0 * ls + j0), ls,
+                                     reinterpret_cast<float *>(dst + j0 * ld + i0), ld);
+                    }
+                    for (size_t i{i0}; i < i0 + 8; i++)
+                    {
+                        for (size_t j{j0}; j < cols; j++)
+                        {
+                            dst[j * ld + i] = src[i * ls + j];
+                        }
+                    }
+                }
+            }
+#endif
+            for (size_t i{i0}; i < rows; i++)
+            {
+                for (size_t j{0}; j < cols; j++)
+                {
+                    dst[j * ld + i] = src[i * ls + j];
+                }
+            }
+        }
+
+        // Run the two halves of a recursive split on the work-stealing scheduler when the block is big
+        // enough to be worth it.
+        template <class F, class G>
+        void split(size_t const elements, F &&f, G &&g)
+        {
+            if (elements >= parallel_threshold)
+            {
+                fork_join(f, g);
+            }
+            else
+            {
+                f();
+                g();
+            }
+        }
+
+        // Cache-oblivious out-of-place transpose: halve the longer side until the block is a leaf.
+        template <class T>
+        void transpose_block(const T *src, size_t const ls, T *dst, size_t const ld, size_t const rows, size_t const cols)
+        {
+            if (rows <= transpose_leaf && cols <= transpose_leaf)
+            {
+                transpose_leaf_block(src, ls, dst, ld, rows, cols);
+            }
+            else if (rows >= cols)
+            {
+                size_t const h = (rows / 2 + 7) & ~size_t{7}; // Keep splits on 8x8 tile boundaries.
+                split(
+                    rows * cols, [&]
+                    { transpose_block(src, ls, dst, ld, h, cols); },
+                    [&]
+                    { transpose_block(src + h * ls, ls, dst + h, ld, rows - h, cols); });
+            }
+            else
+            {
+                size_t const h = (cols / 2 + 7) & ~size_t{7};
+                split(
+                    rows * cols, [&]
+                    { transpose_block(src, ls, dst, ld, rows, h); },
+                    [&]
+                    { transpose_block(src + h, ls, dst + h * ld, ld, rows, cols - h); });
+            }
+        }
+
+        // Swap x[i][j] with y[j][i] for a rows x cols block x and the cols x rows block y.
+        template <class T>
+        void swap_transposed(T *x, T *y, size_t const ld, size_t const rows, size_t const cols)
+        {
+            if (rows <= transpose_leaf && cols <= transpose_leaf)
+            {
+                for (size_t i{0}; i < rows; i++)
+                {
+                    for (size_t j{0}; j < cols; j++)
+                    {
+                        std::swap(x[i * ld + j], y[j * ld + i]);
+                    }
+                }
+            }
+            else if (rows >= cols)
+            {
+                size_t const h = rows / 2;
+                split(
+                    rows * cols, [&]
+                    { swap_transposed(x, y, ld, h, cols); },
+                    [&]
+                    { swap_transposed(x + h * ld, y + h, ld, rows - h, cols); });
+            }
+            else
+            {
+                size_t const h = cols / 2;
+                split(
+                    rows * cols, [&]
+                    { swap_transposed(x, y, ld, rows, h); },
+                    [&]
+                    { swap_transposed(x + h, y + h * ld, ld, rows, cols - h); });
+            }
+        }
+
+        // Cache-oblivious in-place transpose of the n x n block at a.
+        template <class T>
+        void transpose_square(T *a, size_t const ld, size_t const n)
+        {
+            if (n <= transpose_leaf)
+            {
+                for (size_t i{0}; i < n; i++)
+                {
+                    for (size_t j{i + 1}; j < n; j++)
+                    {
+                        std::swap(a[i * ld + j], a[j * ld + i]);
+                    }
+                }
+                return;
+            }
+            size_t const h = n / 2;
+            split(
+                n * n, [&]
+                { split(
+                      n * n / 2, [&]
+                      { transpose_square(a, ld, h); },
+                      [&]
+                      { transpose_square(a + h * ld + h, ld, n - h); }); },
+                [&]
+                { swap_transposed(a + h, a + h * ld, ld, h, n - h); });
+        }
+
+    } // namespace detail
+
+    // Return the transpose of a matrix. The cache-oblivious recursion forks its halves onto the
+    // work-stealing scheduler until blocks drop below parallel_threshold elements.
+    template <class T, size_t ROW, size_t COL, class S>
+    SimpleMatrix<T, COL, ROW, result_layout_t<S>> transpose(const SimpleMatrix<T, ROW, COL, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("transpose", COL, ROW, 0, 0, 2 * ROW * COL * sizeof(T));
+        SimpleMatrix<T, COL, ROW, result_layout_t<S>> result;
+        const T *src = m.data();
+        T *dst = result.data();
+        size_t const ls = m.stride();
+        size_t const ld = result.stride();
+
+        detail::transpose_block(src, ls, dst, ld, ROW, COL);
+
+        return result;
+    }
+
+    // Transpose a square matrix in place. The two diagonal blocks and the off-diagonal swap of each
+    // recursion step touch disjoint elements, so all three are forked.
+    template <class T, size_t N, class S>
+    void transpose_inplace(SimpleMatrix<T, N, N, S> &m)
+    {
+        MATRIX_INSTRUMENT_SCOPE("transpose_inplace", N, N, 0, 0, 2 * N * N * sizeof(T));
+        detail::transpose_square(m.data(), m.stride(), N);
+    }
+
+} // namespace matrix
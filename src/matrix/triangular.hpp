@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "matrix.hpp"
+#include "kernels.hpp"
+#include "parallel.hpp"
+#include "symmetric.hpp"
+
+namespace matrix
+{
+
+    // Whether the diagonal of a triangular matrix is implicitly all ones.
+    enum class Diagonal
+    {
+        NonUnit,
+        Unit
+    };
+
+    // Rows of a triangular solve that are updated in parallel and then substituted serially.
+    inline constexpr size_t triangular_block_size = 64;
+
+    // TriangularMatrix: An N x N upper or lower triangular matrix, packed row by row in N*(N+1)/2 elements
+    // (the layout of SymmetricMatrix). A Unit matrix keeps the slots of its diagonal but never reads them.
+    template <typename T, size_t N, Triangle UPLO = Triangle::Lower, Diagonal DIAG = Diagonal::NonUnit>
+    class TriangularMatrix
+    {
+        std::vector<T> data_;
+
+    public:
+        static constexpr size_t packed_size = N * (N + 1) / 2;
+
+        // Offset of element (r, c) in the packed array; (r, c) must lie in the stored triangle.
+        static constexpr size_t index(size_t const r, size_t const c)
+        {
+            return SymmetricMatrix<T, N, UPLO>::index(r, c);
+        }
+
+        // Whether (r, c) lies in the stored triangle, the diagonal included.
+        static constexpr bool stored(size_t const r, size_t const c)
+        {
+            return UPLO == Triangle::Lower ? c <= r : c >= r;
+        }
+
+        // Constructor: Initialize the matrix with default-initialized elements.
+        TriangularMatrix() : data_(packed_size) {}
+
+        // Constructor: Initialize the stored triangle, row by row, from an initializer list.
+        explicit TriangularMatrix(std::initializer_list<T> init_list) : data_(init_list)
+        {
+            if (init_list.size() != packed_size)
+            {
+                throw std::invalid_argument("Invalid initializer list size");
+            }
+        }
+
+        // Constructor: Take the triangle of a dense matrix; the other triangle is ignored.
+        template <class S>
+        explicit TriangularMatrix(const SimpleMatrix<T, N, N, S> &m) : data_(packed_size)
+        {
+            for (size_t i{0}; i < N; i++)
+            {
+                const T *src = m.row(i);
+                if constexpr (UPLO == Triangle::Lower)
+                {
+                    std::copy(src, src + i + 1, row(i));
+                }
+                else
+                {
+                    std::copy(src + i, src + N, row(i));
+                }
+            }
+        }
+
+        // Constructor: Take a Cholesky factor, which is packed in the same layout.
+        explicit TriangularMatrix(const SymmetricMatrix<T, N, UPLO> &factor) : data_(factor.data(), factor.data() + packed_size) {}
+
+        // Element at a specific row and column: zero outside the triangle, one on a Unit diagonal.
+        constexpr T at(size_t const r, size_t const c) const
+        {
+            if (r >= N || c >= N)
+            {
+                throw std::out_of_range("r >= N || c >= N");
+            }
+            if (DIAG == Diagonal::Unit && r == c)
+            {
+                return T{1};
+            }
+            return stored(r, c) ? data_[index(r, c)] : T{};
+        }
+
+        // Mutable reference to an element of the stored triangle; throws std::out_of_range for any other.
+        constexpr T &element(size_t const r, size_t const c)
+        {
+            if (r >= N || c >= N)
+            {
+                throw std::out_of_range("r >= N || c >= N");
+            }
+            if (!stored(r, c))
+            {
+                throw std::out_of_range("Element is outside the stored triangle");
+            }
+            return data_[index(r, c)];
+        }
+
+        // Stored part of row r: columns [0, r] for Lower, [r, N) for Upper.
+        T *row(size_t const r)
+        {
+            return data_.data() + index(r, UPLO == Triangle::Lower ? 0 : r);
+        }
+
+        const T *row(size_t const r) const
+        {
+            return data_.data() + index(r, UPLO == Triangle::Lower ? 0 : r);
+        }
+
+        // Row r addressed by column: element c of the result is (r, c) for every stored column c.
+        const T *row_by_column(size_t const r) const
+        {
+            return UPLO == Triangle::Lower ? row(r) : row(r) - r;
+        }
+
+        // Pointer to the packed storage.
+        T *data()
+        {
+            return data_.data();
+        }
+
+        const T *data() const
+        {
+            return data_.data();
+        }
+
+        // Expand into a dense matrix with zeros outside the triangle.
+        SimpleMatrix<T, N, N> dense() const
+        {
+            SimpleMatrix<T, N, N> result;
+            for (size_t i{0}; i < N; i++)
+            {
+                T *out = result.row(i);
+                for (size_t j{0}; j < N; j++)
+                {
+                    out[j] = at(i, j);
+                }
+            }
+            return result;
+        }
+
+        // Equality operator: compares the elements the matrices read.
+        friend bool operator==(const TriangularMatrix &lhs, const TriangularMatrix &rhs)
+        {
+            for (size_t i{0}; i < N; i++)
+            {
+                for (size_t j{UPLO == Triangle::Lower ? 0 : i}; j < (UPLO == Triangle::Lower ? i + 1 : N); j++)
+                {
+                    if (lhs.at(i, j) != rhs.at(i, j))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Output operator to display the full matrix.
+        friend std::ostream &operator<<(std::ostream &os, const TriangularMatrix &m)
+        {
+            return os << m.dense();
+        }
+    }; // TriangularMatrix
+
+    namespace detail
+    {
+
+        // Columns [lo, hi) of row r of a triangular matrix that are read from storage.
+        template <size_t N, Triangle UPLO, Diagonal DIAG>
+        constexpr std::pair<size_t, size_t> stored_columns(size_t const r)
+        {
+            size_t const unit = DIAG == Diagonal::Unit ? 1 : 0;
+            return UPLO == Triangle::Lower ? std::pair{size_t{0}, r + 1 - unit} : std::pair{r + unit, N};
+        }
+
+        // C = A * B for the triangular A and the k-column B (row strides ldb and ldc; C starts zeroed).
+        // Rows of C run in parallel; each reads only the stored part of its row of A.
+        template <class T, size_t N, Triangle UPLO, Diagonal DIAG>
+        void triangular_multiply(const TriangularMatrix<T, N, UPLO, DIAG> &a, const T *b, size_t ldb, T *c, size_t ldc, size_t k)
+        {
+            std::vector<T> buffer;
+            if (k == 1)
+            {
+                b = packed(b, ldb, N, buffer);
+                ldb = 1;
+            }
+            size_t const grain = std::max<size_t>(1, 2 * parallel_threshold / (N * k + 1));
+            parallel_for(0, N, grain, [&](size_t lo, size_t hi)
+                         {
+                             for (size_t i{lo}; i < hi; i++)
+                             {
+                                 const T *ai = a.row_by_column(i);
+                                 auto const [j0, j1] = stored_columns<N, UPLO, DIAG>(i);
+                                 T *ci = c + i * ldc;
+                                 if (k == 1)
+                                 {
+                                     ci[0] = dot(ai + j0, b + j0, j1 - j0) + (DIAG == Diagonal::Unit ? b[i] : T{});
+                                     continue;
+                                 }
+                                 if constexpr (DIAG == Diagonal::Unit)
+                                 {
+                                     std::copy(b + i * ldb, b + i * ldb + k, ci);
+                                 }
+                                 for (size_t j{j0}; j < j1; j++)
+                                 {
+                                     axpy(ai[j], b + j * ldb, ci, k);
+                                 }
+                             } });
+        }
+
+        // Subtract columns [j0, j1) of row i of A times rows [j0, j1) of X from row i of X.
+        template <class T, size_t N, Triangle UPLO, Diagonal DIAG>
+        void triangular_update(const TriangularMatrix<T, N, UPLO, DIAG> &a, T *x, size_t ldx, size_t k, size_t i, size_t j0, size_t j1)
+        {
+            const T *ai = a.row_by_column(i);
+            if (k == 1)
+            {
+                x[i] -= dot(ai + j0, x + j0, j1 - j0);
+                return;
+            }
+            for (size_t j{j0}; j < j1; j++)
+            {
+                axpy(-ai[j], x + j * ldx, x + i * ldx, k);
+            }
+        }
+
+        // Finish row i of X once the update has subtracted every other stored column.
+        template <class T, size_t N, Triangle UPLO, Diagonal DIAG>
+        void triangular_pivot(const TriangularMatrix<T, N, UPLO, DIAG> &a, T *x, size_t ldx, size_t k, size_t i)
+        {
+            if constexpr (DIAG == Diagonal::NonUnit)
+            {
+                T const inv = T{1} / a.row_by_column(i)[i];
+                T *xi = x + i * ldx;
+                for (size_t c{0}; c < k; c++)
+                {
+                    xi[c] *= inv;
+                }
+            }
+        }
+
+        // Solve A * X = B in place for the triangular A and the k-column B (row stride ldx), a block of
+        // triangular_block_size rows at a time: the rows of the block first subtract the contribution of
+        // every row already solved, in parallel and each streaming its row of A contiguously, then the
+        // block is substituted serially. A single column (TRSV) uses dot products.
+        template <class T, size_t N, Triangle UPLO, Diagonal DIAG>
+        void triangular_solve(const TriangularMatrix<T, N, UPLO, DIAG> &a, T *x, size_t ldx, size_t k)
+        {
+            size_t const nb = triangular_block_size;
+            for (size_t b{0}; b < N; b += nb)
+            {
+                // Rows [k0, k1) form the block; columns [s0, s1) are the rows already solved.
+                size_t const k0 = UPLO == Triangle::Lower ? b : N - std::min(N, b + nb);
+                size_t const k1 = UPLO == Triangle::Lower ? std::min(N, b + nb) : N - b;
+                size_t const s0 = UPLO == Triangle::Lower ? 0 : k1;
+                size_t const s1 = UPLO == Triangle::Lower ? k0 : N;
+                size_t const grain = std::max<size_t>(1, parallel_threshold / (2 * (s1 - s0 + 1) * k));
+                parallel_for(k0, k1, grain, [&](size_t lo, size_t hi)
+                             {
+                                 for (size_t i{lo}; i < hi; i++)
+                                 {
+                                     triangular_update(a, x, ldx, k, i, s0, s1);
+                                 } });
+                for (size_t step{0}; step < k1 - k0; step++)
+                {
+                    size_t const i = UPLO == Triangle::Lower ? k0 + step : k1 - 1 - step;
+                    if constexpr (UPLO == Triangle::Lower)
+                    {
+                        triangular_update(a, x, ldx, k, i, k0, i);
+                    }
+                    else
+                    {
+                        triangular_update(a, x, ldx, k, i, i + 1, k1);
+                    }
+                    triangular_pivot(a, x, ldx, k, i);
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // Product of a triangular matrix and a dense matrix, in about half the flops of the dense product.
+    template <class T, size_t N, Triangle UPLO, Diagonal DIAG, size_t K, class S>
+    SimpleMatrix<T, N, K, result_layout_t<S>> operator*(const TriangularMatrix<T, N, UPLO, DIAG> &a, const SimpleMatrix<T, N, K, S> &b)
+    {
+        MATRIX_INSTRUMENT_SCOPE("triangular_multiply", N, K, N, N * (N + 1) * K, (a.packed_size + 2 * N * K) * sizeof(T));
+        SimpleMatrix<T, N, K, result_layout_t<S>> result;
+        detail::triangular_multiply(a, b.data(), b.stride(), result.data(), result.stride(), K);
+        return result;
+    }
+
+    // Solve A * X = B in place for a triangular A (TRSM; TRSV when B is a single column).
+    template <class T, size_t N, Triangle UPLO, Diagonal DIAG, size_t K, class S>
+    SimpleMatrix<T, N, K, S> &triangular_solve_inplace(const TriangularMatrix<T, N, UPLO, DIAG> &a, SimpleMatrix<T, N, K, S> &b)
+    {
+        MATRIX_INSTRUMENT_SCOPE("triangular_solve", N, K, N, N * N * K, (a.packed_size + 2 * N * K) * sizeof(T));
+        T *const data = b.data(); // Once, before the threads start: this detaches shared storage.
+        if (K == 1 && b.stride() != 1)
+        {
+            std::vector<T> x(N);
+            for (size_t i{0}; i < N; i++)
+            {
+                x[i] = data[i * b.stride()];
+            }
+            detail::triangular_solve(a, x.data(), 1, 1);
+            for (size_t i{0}; i < N; i++)
+            {
+                data[i * b.stride()] = x[i];
+            }
+            return b;
+        }
+        detail::triangular_solve(a, data, b.stride(), K);
+        return b;
+    }
+
+    // Solve A * X = B for a triangular A.
+    template <class T, size_t N, Triangle UPLO, Diagonal DIAG, size_t K, class S>
+    SimpleMatrix<T, N, K, result_layout_t<S>> triangular_solve(const TriangularMatrix<T, N, UPLO, DIAG> &a, const SimpleMatrix<T, N, K, S> &b)
+    {
+        SimpleMatrix<T, N, K, result_layout_t<S>> x(b);
+        triangular_solve_inplace(a, x);
+        return x;
+    }
+
+    // Solve A * X = B in the storage of an expiring B.
+    template <class T, size_t N, Triangle UPLO, Diagonal DIAG, size_t K, class S>
+        requires(std::is_same_v<result_layout_t<S>, S>)
+    SimpleMatrix<T, N, K, S> triangular_solve(const TriangularMatrix<T, N, UPLO, DIAG> &a, SimpleMatrix<T, N, K, S> &&b)
+    {
+        triangular_solve_inplace(a, b);
+        return std::move(b);
+    }
+
+} // namespace matrix
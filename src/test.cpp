@@ -1,5 +1,24 @@
 #include "include/acutest.h"
 #include "matrix/matrix.hpp"
+#include "matrix/symmetric.hpp"
+#include "matrix/triangular.hpp"
+#include "matrix/banded.hpp"
+#include "matrix/covariance.hpp"
+#include "matrix/distance.hpp"
+#include "matrix/quantized.hpp"
+#include "matrix/transpose.hpp"
+#include "matrix/batch.hpp"
+#include "matrix/scheduler.hpp"
+#include "matrix/out_of_core.hpp"
+#include "bench/baseline.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
 
 using namespace matrix;
 
@@ -132,6 +151,1803 @@ void test_matrix_iteration_out_of_range_error_col()
     TEST_EXCEPTION(matrix[1][5] = 4, std::out_of_range);
 }
 
+// Helper function to compare two matrices element-wise within a tolerance
+template <class M>
+bool approxEqual(const M &a, const M &b, double tolerance = 1e-9)
+{
+    return std::equal(a.cbegin(), a.cend(), b.cbegin(), [&](auto x, auto y)
+                      { return std::abs(double(x) - double(y)) <= tolerance * (1.0 + std::abs(double(y))); });
+}
+
+// Helper function to create a random symmetric positive definite matrix (diagonally dominant)
+template <size_t N>
+SimpleMatrix<double, N, N> createSpdMatrix(unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    SimpleMatrix<double, N, N> m;
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t j = 0; j <= i; j++)
+        {
+            double const v = dist(gen);
+            m[i][j] = v;
+            m[j][i] = v;
+        }
+        m[i][i] = N + 1.0;
+    }
+    return m;
+}
+
+// Test Cholesky factorization of a small SPD matrix
+void test_cholesky_factor()
+{
+    // Arrange
+    SymmetricMatrix<double, 3> a{
+        4,
+        12, 37,
+        -16, -43, 98};
+
+    // Act
+    auto l = cholesky(a);
+
+    // Assert
+    SymmetricMatrix<double, 3> expected{
+        2,
+        6, 1,
+        -8, 5, 3};
+    TEST_CHECK(l == expected);
+}
+
+// Test SPD solve with both packed triangles across several Cholesky blocks
+void test_cholesky_solve()
+{
+    // Arrange
+    constexpr size_t N = 150;
+    auto dense = createSpdMatrix<N>(42);
+    SimpleMatrix<double, N, 2> x;
+    for (size_t i = 0; i < N; i++)
+    {
+        x[i][0] = double(i);
+        x[i][1] = 1.0 - double(i % 7);
+    }
+    auto b = dense * x;
+
+    // Act
+    auto lower = solve_spd(SymmetricMatrix<double, N, Triangle::Lower>(dense), b);
+    auto upper = solve_spd(SymmetricMatrix<double, N, Triangle::Upper>(dense), b);
+
+    // Assert
+    TEST_CHECK(approxEqual(lower, x));
+    TEST_CHECK(approxEqual(upper, x));
+}
+
+// Test that non-SPD input is reported with the failing pivot
+void test_cholesky_not_positive_definite()
+{
+    // Arrange
+    SymmetricMatrix<double, 3, Triangle::Upper> a{
+        1, 2, 0,
+        1, 0,
+        1};
+
+    // Act and Assert
+    TEST_EXCEPTION(cholesky(a), not_positive_definite);
+    try
+    {
+        cholesky(a);
+    }
+    catch (const not_positive_definite &e)
+    {
+        TEST_CHECK(e.column() == 1);
+    }
+}
+
+// Test that the thread pool runs every task once and forwards exceptions
+void test_thread_pool()
+{
+    // Arrange
+    ThreadPool pool(4);
+    std::vector<int> hits(1000);
+
+    // Act
+    pool.run(hits.size(), [&](size_t i)
+             { hits[i]++; });
+
+    // Assert
+    TEST_CHECK(std::all_of(hits.begin(), hits.end(), [](int h)
+                           { return h == 1; }));
+    TEST_EXCEPTION(pool.run(8, [](size_t i)
+                            { if (i == 5) throw std::runtime_error("task"); }),
+                   std::runtime_error);
+}
+
+// Test half and bfloat16 rounding at the edges of their ranges
+void test_compact_float_conversion()
+{
+    // Act and Assert
+    TEST_CHECK(half(1.0f).bits() == 0x3c00);
+    TEST_CHECK(half(0.1f).bits() == 0x2e66);
+    TEST_CHECK(half(65504.0f).bits() == 0x7bff);
+    TEST_CHECK(half(65520.0f).bits() == 0x7c00);
+    TEST_CHECK(half(std::ldexp(1.0f, -24)).bits() == 0x0001);
+    TEST_CHECK(half(std::ldexp(1.0f, -25)).bits() == 0x0000);
+    TEST_CHECK(float(half::from_bits(0x0001)) == std::ldexp(1.0f, -24));
+    TEST_CHECK(std::isnan(float(half(NAN))));
+    TEST_CHECK(bfloat16(1.0f + std::ldexp(1.0f, -8)).bits() == 0x3f80);
+    TEST_CHECK(bfloat16(1.0f + 3 * std::ldexp(1.0f, -8)).bits() == 0x3f82);
+    TEST_CHECK(float(bfloat16(-2.5f)) == -2.5f);
+}
+
+// Test that the bulk conversion kernels match scalar rounding
+void test_compact_float_bulk_conversion()
+{
+    // Arrange
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(-70000.0f, 70000.0f);
+    std::vector<float> src(1003);
+    for (size_t i = 0; i < src.size(); i++)
+    {
+        src[i] = i % 3 ? dist(gen) : dist(gen) * 1e-9f;
+    }
+    std::vector<half> h(src.size());
+    std::vector<bfloat16> b(src.size());
+    std::vector<float> back(src.size());
+
+    // Act
+    detail::narrow(src.data(), h.data(), src.size());
+    detail::narrow(src.data(), b.data(), src.size());
+
+    // Assert
+    for (size_t i = 0; i < src.size(); i++)
+    {
+        TEST_CHECK(h[i].bits() == half(src[i]).bits());
+        TEST_CHECK(b[i].bits() == bfloat16(src[i]).bits());
+    }
+    detail::widen(h.data(), back.data(), h.size());
+    for (size_t i = 0; i < src.size(); i++)
+    {
+        TEST_CHECK(back[i] == float(h[i]));
+    }
+}
+
+// Test half matrix operations accumulate in float and round once
+void test_compact_float_operations()
+{
+    // Arrange
+    constexpr size_t N = 40;
+    SimpleMatrix<float, N, N> a;
+    SimpleMatrix<float, N, N> b;
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t j = 0; j < N; j++)
+        {
+            a[i][j] = float(half(0.01f * float(i + j)));
+            b[i][j] = float(half(1.0f - 0.02f * float(i)));
+        }
+    }
+    auto ah = matrix_cast<half>(a);
+    auto bh = matrix_cast<bfloat16>(b);
+
+    // Act
+    auto product = ah * matrix_cast<half>(b);
+    auto added = bh + bh;
+    float total = sum(ah);
+
+    // Assert
+    TEST_CHECK(product == matrix_cast<half>(a * b));
+    TEST_CHECK(added == matrix_cast<bfloat16>(b + b));
+    TEST_CHECK(std::abs(total - sum(a)) <= 1e-3f * std::abs(sum(a)));
+}
+
+// Helper function to fill a matrix with uniformly distributed integers
+template <class T, size_t ROW, size_t COL>
+void fillRandomIntegers(SimpleMatrix<T, ROW, COL> &m, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+    for (auto &value : m)
+    {
+        value = T(dist(gen));
+    }
+}
+
+// Helper function computing a reference wide product with a plain triple loop
+template <class T, size_t ROW1, size_t COL1, size_t COL2>
+SimpleMatrix<int64_t, ROW1, COL2> referenceProduct(const SimpleMatrix<T, ROW1, COL1> &a, const SimpleMatrix<T, COL1, COL2> &b)
+{
+    SimpleMatrix<int64_t, ROW1, COL2> result;
+    for (size_t i = 0; i < ROW1; i++)
+    {
+        for (size_t j = 0; j < COL2; j++)
+        {
+            for (size_t k = 0; k < COL1; k++)
+            {
+                result[i][j] += int64_t(a.at(i, k)) * int64_t(b.at(k, j));
+            }
+        }
+    }
+    return result;
+}
+
+// Test int8 and int16 products are exact in their wide accumulators, up to the deepest int8 product
+// that cannot overflow int32
+void test_multiply_wide()
+{
+    // Arrange
+    constexpr size_t deepest = detail::wide_depth<int8_t>;
+    auto row = std::make_unique<SimpleMatrix<int8_t, 1, deepest>>();
+    auto column = std::make_unique<SimpleMatrix<int8_t, deepest, 1>>();
+    std::fill(row->begin(), row->end(), std::numeric_limits<int8_t>::min());
+    std::fill(column->begin(), column->end(), std::numeric_limits<int8_t>::min());
+    SimpleMatrix<int8_t, 9, 131> a8;
+    SimpleMatrix<int8_t, 131, 7> b8;
+    SimpleMatrix<int16_t, 5, 77> a16;
+    SimpleMatrix<int16_t, 77, 6> b16;
+    fillRandomIntegers(a8, 1);
+    fillRandomIntegers(b8, 2);
+    fillRandomIntegers(a16, 3);
+    fillRandomIntegers(b16, 4);
+    for (auto &value : a16)
+    {
+        value = value < 0 ? std::numeric_limits<int16_t>::min() : value;
+    }
+    for (auto &value : b16)
+    {
+        value = std::numeric_limits<int16_t>::min();
+    }
+
+    // Act
+    SimpleMatrix<int32_t, 9, 7> c8 = multiply_wide(a8, b8);
+    SimpleMatrix<int64_t, 5, 6> c16 = multiply_wide(a16, b16);
+    auto const extreme = multiply_wide(*row, *column);
+
+    // Assert
+    TEST_CHECK(deepest == (size_t{1} << 17) - 1 && detail::wide_depth<int16_t> == (size_t{1} << 33) - 1 && detail::wide_depth<int32_t> == 1);
+    TEST_CHECK(extreme.at(0, 0) == int32_t(128 * 128 * deepest));
+    TEST_CHECK(matrix_cast<int64_t>(c8) == referenceProduct(a8, b8));
+    TEST_CHECK(c16 == referenceProduct(a16, b16));
+}
+
+// Test per-row and per-column dequantization scales
+void test_multiply_scaled()
+{
+    // Arrange
+    SimpleMatrix<int8_t, 2, 3> a{
+        1, 2, 3,
+        -4, 5, -6};
+    SimpleMatrix<int8_t, 3, 2> b{
+        7, -8,
+        9, 10,
+        -11, 12};
+
+    // Act
+    auto c = multiply_scaled(a, b, std::array<float, 2>{0.5f, 2.0f}, std::array<float, 2>{1.0f, 0.25f});
+    auto uniform = multiply_scaled(a, b, 0.5f, 0.25f);
+
+    // Assert
+    SimpleMatrix<float, 2, 2> expected{
+        0.5f * -8, 0.5f * 0.25f * 48,
+        2.0f * 83, 2.0f * 0.25f * 10};
+    SimpleMatrix<float, 2, 2> expected_uniform{
+        0.125f * -8, 0.125f * 48,
+        0.125f * 83, 0.125f * 10};
+    TEST_CHECK(c == expected);
+    TEST_CHECK(uniform == expected_uniform);
+}
+
+// Test resizing pads with zeros and truncates extra rows and columns
+void test_matrix_resize()
+{
+    // Arrange
+    Matrix3x5 matrix = createSampleMatrix();
+
+    // Act
+    auto grown = resize<4, 6>(matrix);
+    auto shrunk = resize<2, 3>(matrix);
+
+    // Assert
+    SimpleMatrix<int, 4, 6> expected_grown{
+        0, 1, 2, 3, 4, 0,
+        5, 6, 7, 8, 9, 0,
+        8, 7, 6, 5, 4, 0,
+        0, 0, 0, 0, 0, 0};
+    SimpleMatrix<int, 2, 3> expected_shrunk{
+        0, 1, 2,
+        5, 6, 7};
+    TEST_CHECK(grown == expected_grown);
+    TEST_CHECK(shrunk == expected_shrunk);
+}
+
+// Test horizontal concatenation of matrices with different row counts
+void test_matrix_concatenation()
+{
+    // Arrange
+    Matrix3x5 matrix = createSampleMatrix();
+    SimpleMatrix<int, 2, 2> small{
+        1, 2,
+        3, 4};
+    SimpleMatrix<std::string, 1, 2> left{"a", "b"};
+    SimpleMatrix<std::string, 2, 1> right{"c", "d"};
+
+    // Act
+    auto joined = matrix | small;
+    auto words = left | right;
+
+    // Assert
+    SimpleMatrix<int, 3, 7> expected{
+        0, 1, 2, 3, 4, 1, 2,
+        5, 6, 7, 8, 9, 3, 4,
+        8, 7, 6, 5, 4, 0, 0};
+    SimpleMatrix<std::string, 2, 3> expected_words{
+        "a", "b", "c",
+        "", "", "d"};
+    TEST_CHECK(joined == expected);
+    TEST_CHECK(words == expected_words);
+}
+
+// Test large concatenation takes the row-parallel copy path
+void test_matrix_large_concatenation()
+{
+    // Arrange
+    auto a = std::make_unique<SimpleMatrix<float, 300, 300>>();
+    auto b = std::make_unique<SimpleMatrix<float, 200, 100>>();
+    std::iota(a->begin(), a->end(), 0.0f);
+    std::iota(b->begin(), b->end(), -1.0f);
+
+    // Act
+    auto joined = *a | *b;
+
+    // Assert
+    TEST_CHECK(joined.at(299, 299) == a->at(299, 299));
+    TEST_CHECK(joined.at(199, 399) == b->at(199, 99));
+    TEST_CHECK(joined.at(200, 300) == 0.0f);
+    TEST_CHECK((resize<300, 300>(joined) == *a));
+}
+
+// Test variadic hconcat/vconcat and block assembly allocate the result once
+void test_matrix_block_assembly()
+{
+    // Arrange
+    SimpleMatrix<int, 2, 2> a{
+        1, 2,
+        3, 4};
+    SimpleMatrix<int, 2, 1> b{5, 6};
+    PaddedMatrix<int, 1, 3> c{7, 8, 9};
+    SimpleMatrix<int, 1, 1> d{0};
+    auto big = std::make_unique<SimpleMatrix<float, 128, 96>>();
+    auto rhs = std::make_unique<SimpleMatrix<float, 128, 1>>();
+    std::iota(big->begin(), big->end(), 0.0f);
+    std::iota(rhs->begin(), rhs->end(), -1.0f);
+
+    // Act
+    auto row = hconcat(a, b, a);
+    auto stacked = vconcat(a, c, b);
+    auto assembled = block(std::tie(a, b), std::tie(c, d));
+    AllocationCounter counter;
+    auto augmented = hconcat(*big, *rhs, *rhs);
+    uint64_t const calls = counter.calls();
+
+    // Assert
+    SimpleMatrix<int, 2, 5> expected_row{
+        1, 2, 5, 1, 2,
+        3, 4, 6, 3, 4};
+    SimpleMatrix<int, 5, 3> expected_stacked{
+        1, 2, 0,
+        3, 4, 0,
+        7, 8, 9,
+        5, 0, 0,
+        6, 0, 0};
+    SimpleMatrix<int, 3, 4> expected_assembled{
+        1, 2, 5, 0,
+        3, 4, 6, 0,
+        7, 8, 9, 0};
+    TEST_CHECK(row == expected_row);
+    TEST_CHECK(stacked == expected_stacked);
+    TEST_CHECK(assembled == expected_assembled);
+    TEST_CHECK(calls == 1);
+    TEST_CHECK((resize<128, 96>(augmented) == *big));
+    TEST_CHECK(augmented.at(127, 96) == rhs->at(127, 0));
+    TEST_CHECK(augmented.at(0, 97) == -1.0f);
+}
+
+// Test transposing a small matrix
+void test_matrix_transpose()
+{
+    // Arrange
+    Matrix3x5 matrix = createSampleMatrix();
+
+    // Act
+    SimpleMatrix<int, 5, 3> transposed = transpose(matrix);
+
+    // Assert
+    SimpleMatrix<int, 5, 3> expected{
+        0, 5, 8,
+        1, 6, 7,
+        2, 7, 6,
+        3, 8, 5,
+        4, 9, 4};
+    TEST_CHECK(transposed == expected);
+}
+
+// Test transposing shapes that cross several recursion levels and partial 8x8 tiles
+void test_matrix_transpose_large()
+{
+    // Arrange
+    auto a = std::make_unique<SimpleMatrix<float, 75, 130>>();
+    auto b = std::make_unique<SimpleMatrix<double, 101, 67>>();
+    std::iota(a->begin(), a->end(), 0.0f);
+    std::iota(b->begin(), b->end(), 0.0);
+
+    // Act
+    auto at = transpose(*a);
+    auto bt = transpose(*b);
+
+    // Assert
+    bool ok = true;
+    for (size_t i = 0; i < 75; i++)
+    {
+        for (size_t j = 0; j < 130; j++)
+        {
+            ok = ok && at.at(j, i) == a->at(i, j);
+        }
+    }
+    TEST_CHECK(ok);
+    TEST_CHECK((transpose(bt) == *b));
+}
+
+// Test in-place transpose of a square matrix
+void test_matrix_transpose_inplace()
+{
+    // Arrange
+    auto m = std::make_unique<SimpleMatrix<int, 97, 97>>();
+    std::iota(m->begin(), m->end(), 0);
+    auto expected = transpose(*m);
+
+    // Act
+    transpose_inplace(*m);
+
+    // Assert
+    TEST_CHECK(*m == expected);
+}
+
+// Test padded rows are aligned and use a stride that is an odd number of cache lines
+void test_matrix_padded_storage()
+{
+    // Arrange
+    auto dense = std::make_unique<SimpleMatrix<float, 64, 1024>>();
+    auto padded = std::make_unique<PaddedMatrix<float, 64, 1024>>();
+
+    // Act
+    std::iota(dense->begin(), dense->end(), 0.0f);
+    for (size_t i{0}; i < 64; i++)
+    {
+        std::copy(dense->row(i), dense->row(i) + 1024, padded->row(i));
+    }
+
+    // Assert
+    TEST_CHECK(reinterpret_cast<uintptr_t>(dense->data()) % default_alignment == 0);
+    TEST_CHECK(reinterpret_cast<uintptr_t>(padded->data()) % default_alignment == 0);
+    TEST_CHECK(padded->stride() == 1040); // 64 cache lines of floats plus one to break set aliasing.
+    TEST_CHECK(reinterpret_cast<uintptr_t>(padded->row(63)) % default_alignment == 0);
+    TEST_CHECK((padded_stride<float, 3, 64>() == 16));
+    TEST_CHECK(padded->at(63, 1023) == dense->at(63, 1023));
+    TEST_CHECK((*padded)[5][7] == (*dense)[5][7]);
+}
+
+// Test operations on padded matrices match the dense results
+void test_matrix_padded_operations()
+{
+    // Arrange
+    std::mt19937 gen(31);
+    std::uniform_int_distribution<int> dist(-8, 8);
+    auto a = std::make_unique<SimpleMatrix<double, 67, 130>>();
+    auto b = std::make_unique<SimpleMatrix<double, 130, 45>>();
+    auto pa = std::make_unique<PaddedMatrix<double, 67, 130>>();
+    auto pb = std::make_unique<PaddedMatrix<double, 130, 45>>();
+    std::generate(a->begin(), a->end(), [&]
+                  { return double(dist(gen)); });
+    std::generate(b->begin(), b->end(), [&]
+                  { return double(dist(gen)); });
+    for (size_t i{0}; i < 67; i++)
+    {
+        std::copy(a->row(i), a->row(i) + 130, pa->row(i));
+    }
+    for (size_t i{0}; i < 130; i++)
+    {
+        std::copy(b->row(i), b->row(i) + 45, pb->row(i));
+    }
+
+    // Act
+    auto product = *pa * *pb;
+    auto mixed = *a * *pb;
+    auto transposed = transpose(*pa);
+    auto widened = resize<70, 140>(*pa);
+
+    // Assert
+    auto expected = *a * *b;
+    auto expected_t = transpose(*a);
+    bool same_product = true;
+    bool same_mixed = true;
+    for (size_t i{0}; i < 67; i++)
+    {
+        for (size_t j{0}; j < 45; j++)
+        {
+            same_product = same_product && product.at(i, j) == expected.at(i, j);
+            same_mixed = same_mixed && mixed.at(i, j) == expected.at(i, j);
+        }
+    }
+    bool same_transpose = true;
+    for (size_t i{0}; i < 130; i++)
+    {
+        for (size_t j{0}; j < 67; j++)
+        {
+            same_transpose = same_transpose && transposed.at(i, j) == expected_t.at(i, j);
+        }
+    }
+    TEST_CHECK(same_product);
+    TEST_CHECK(same_mixed);
+    TEST_CHECK(same_transpose);
+    TEST_CHECK(widened.at(66, 129) == a->at(66, 129));
+    TEST_CHECK(widened.at(69, 139) == 0.0);
+}
+
+// Test batched products and sums match per-matrix operators, including the partial last block
+void test_batched_multiply_add()
+{
+    // Arrange
+    constexpr size_t n = 1001; // Not a multiple of the lane count.
+    std::mt19937 gen(32);
+    std::uniform_int_distribution<int> dist(-9, 9);
+    MatrixBatch<float, 3, 4> a(n);
+    MatrixBatch<float, 4, 3> b(n);
+    MatrixBatch<float, 3, 4> c(n);
+    for (size_t k{0}; k < n; k++)
+    {
+        for (size_t i{0}; i < 3; i++)
+        {
+            for (size_t j{0}; j < 4; j++)
+            {
+                a.at(k, i, j) = float(dist(gen));
+                b.at(k, j, i) = float(dist(gen));
+                c.at(k, i, j) = float(dist(gen));
+            }
+        }
+    }
+
+    // Act
+    auto product = batched_multiply(a, b);
+    auto total = batched_add(a, c);
+
+    // Assert
+    bool same = true;
+    for (size_t k{0}; k < n; k++)
+    {
+        same = same && product.get(k) == a.get(k) * b.get(k);
+        same = same && total.get(k) == a.get(k) + c.get(k);
+    }
+    TEST_CHECK(product.size() == n);
+    TEST_CHECK(same);
+    TEST_EXCEPTION(batched_add(a, MatrixBatch<float, 3, 4>(n - 1)), std::invalid_argument);
+    TEST_EXCEPTION(a.at(n, 0, 0), std::out_of_range);
+}
+
+// Test batched inversion with pivoting and singular matrix detection
+void test_batched_inverse()
+{
+    // Arrange
+    constexpr size_t n = 100;
+    MatrixBatch<double, 6, 6> a(n);
+    for (size_t k{0}; k < n; k++)
+    {
+        auto m = createSpdMatrix<6>(unsigned(k));
+        m[0][5] += 1.0; // Not symmetric.
+        a.set(k, m);
+    }
+
+    // Act
+    auto inv = batched_inverse(a);
+
+    // Assert
+    bool identity = true;
+    for (size_t k{0}; k < n; k++)
+    {
+        auto p = a.get(k) * inv.get(k);
+        for (size_t i{0}; i < 6; i++)
+        {
+            for (size_t j{0}; j < 6; j++)
+            {
+                identity = identity && std::abs(p.at(i, j) - (i == j ? 1.0 : 0.0)) < 1e-9;
+            }
+        }
+    }
+    TEST_CHECK(identity);
+
+    MatrixBatch<double, 2, 2> permutation(1); // Needs a row swap.
+    permutation.set(0, SimpleMatrix<double, 2, 2>{0, 1, 1, 0});
+    TEST_CHECK(batched_inverse(permutation).get(0) == permutation.get(0));
+
+    MatrixBatch<double, 2, 2> singular(3);
+    singular.set(0, SimpleMatrix<double, 2, 2>{0, 1, 1, 0});
+    singular.set(1, SimpleMatrix<double, 2, 2>{1, 2, 2, 4});
+    singular.set(2, SimpleMatrix<double, 2, 2>{2, 0, 0, 2});
+    TEST_EXCEPTION(batched_inverse(singular), std::domain_error);
+}
+
+// Test the work-stealing deque hands out every task exactly once under concurrent stealing
+void test_work_deque()
+{
+    // Arrange
+    constexpr size_t n = 20000;
+    std::vector<detail::Task> tasks(n);
+    std::vector<std::atomic<int>> taken(n);
+    detail::WorkDeque deque(4);
+    auto take = [&](detail::Task *t)
+    { taken[size_t(t - tasks.data())]++; };
+
+    // Act
+    deque.push(&tasks[0]);
+    deque.push(&tasks[1]);
+    deque.push(&tasks[2]);
+    bool const lifo = deque.pop() == &tasks[2];
+    bool const fifo = deque.steal() == &tasks[0];
+    take(&tasks[0]);
+    take(deque.pop());
+    take(&tasks[2]);
+
+    std::atomic<bool> finished{false};
+    std::vector<std::thread> thieves;
+    for (int i{0}; i < 3; i++)
+    {
+        thieves.emplace_back([&]
+                             {
+                                 while (!finished.load() || !deque.empty())
+                                 {
+                                     if (detail::Task *t = deque.steal())
+                                     {
+                                         take(t);
+                                     }
+                                 } });
+    }
+    for (size_t i{3}; i < n; i++)
+    {
+        deque.push(&tasks[i]);
+        if (i % 3 == 0)
+        {
+            if (detail::Task *t = deque.pop())
+            {
+                take(t);
+            }
+        }
+    }
+    finished = true;
+    for (auto &t : thieves)
+    {
+        t.join();
+    }
+
+    // Assert
+    TEST_CHECK(lifo);
+    TEST_CHECK(fifo);
+    TEST_CHECK(deque.empty());
+    TEST_CHECK(std::all_of(taken.begin(), taken.end(), [](const auto &c)
+                           { return c.load() == 1; }));
+}
+
+// Recursive sum with uneven splits, so the work per branch is irregular.
+long long forkedSum(TaskScheduler &s, const int *p, size_t n)
+{
+    if (n <= 1000)
+    {
+        return std::accumulate(p, p + n, 0LL);
+    }
+    long long left{0};
+    long long right{0};
+    size_t const h = n / 3;
+    s.fork_join([&]
+                { left = forkedSum(s, p, h); },
+                [&]
+                { right = forkedSum(s, p + h, n - h); });
+    return left + right;
+}
+
+// Test nested fork/join on the work-stealing scheduler and exception forwarding
+void test_task_scheduler()
+{
+    // Arrange
+    TaskScheduler scheduler(4);
+    std::vector<int> values(1 << 20);
+    std::iota(values.begin(), values.end(), -500000);
+    long long const expected = std::accumulate(values.begin(), values.end(), 0LL);
+
+    // Act
+    long long const total = forkedSum(scheduler, values.data(), values.size());
+
+    // Assert
+    TEST_CHECK(total == expected);
+    bool ran_left = false;
+    TEST_EXCEPTION(scheduler.fork_join([&]
+                                       { ran_left = true; },
+                                       []
+                                       { throw std::runtime_error("branch"); }),
+                   std::runtime_error);
+    TEST_CHECK(ran_left);
+    bool ran_right = false;
+    TEST_EXCEPTION(scheduler.fork_join([]
+                                       { throw std::logic_error("left"); },
+                                       [&]
+                                       { ran_right = true;
+                                         throw std::runtime_error("right"); }),
+                   std::logic_error);
+    TEST_CHECK(ran_right); // g still runs when f throws, whether or not it was stolen.
+    bool ran_serial = false;
+    TaskScheduler serial(1);
+    TEST_EXCEPTION(serial.fork_join([]
+                                    { throw std::logic_error("left"); },
+                                    [&]
+                                    { ran_serial = true; }),
+                   std::logic_error);
+    TEST_CHECK(ran_serial);
+    TEST_CHECK(forkedSum(scheduler, values.data(), values.size()) == expected); // Still usable.
+
+    // A parallel_for and a fork_join from two outside threads take turns instead of overlapping.
+    std::atomic<long long> pooled{0};
+    long long forked{0};
+    std::thread other([&]
+                      { forked = forkedSum(scheduler, values.data(), values.size()); });
+    parallel_for(0, values.size(), 1000, [&](size_t lo, size_t hi)
+                 { pooled += std::accumulate(values.begin() + lo, values.begin() + hi, 0LL); });
+    other.join();
+    TEST_CHECK(pooled == expected);
+    TEST_CHECK(forked == expected);
+}
+
+// Test the out-of-core multiply over several C blocks and zero-padded edge tiles
+void test_multiply_out_of_core()
+{
+    // Arrange
+    auto const dir = std::filesystem::temp_directory_path();
+    std::string const pa = (dir / "matrix_test_ooc_a.bin").string();
+    std::string const pb = (dir / "matrix_test_ooc_b.bin").string();
+    std::string const pc = (dir / "matrix_test_ooc_c.bin").string();
+    std::mt19937 gen(34);
+    std::uniform_int_distribution<int> dist(-5, 5);
+    auto a = std::make_unique<SimpleMatrix<double, 70, 50>>();
+    auto b = std::make_unique<SimpleMatrix<double, 50, 90>>();
+    std::generate(a->begin(), a->end(), [&]
+                  { return double(dist(gen)); });
+    std::generate(b->begin(), b->end(), [&]
+                  { return double(dist(gen)); });
+    size_t const tile_bytes = 16 * 16 * sizeof(double);
+
+    {
+        FileMatrix<double> fa(pa, 70, 50, 16);
+        FileMatrix<double> fb(pb, 50, 90, 16);
+        FileMatrix<double> fc(pc, 70, 90, 16);
+        fa.store(*a);
+        fb.store(*b);
+
+        // Act
+        auto const plan = plan_out_of_core(fa, fb, 20 * tile_bytes);
+        multiply_out_of_core(fa, fb, fc, 20 * tile_bytes);
+
+        // Assert
+        TEST_CHECK(plan.bytes <= 20 * tile_bytes);
+        TEST_CHECK(plan.block_rows < fa.tile_rows()); // The budget forces several C blocks.
+        TEST_CHECK((fc.load<70, 90>() == *a * *b));
+        TEST_EXCEPTION(multiply_out_of_core(fa, fb, fc, 5 * tile_bytes), std::invalid_argument);
+        TEST_EXCEPTION(multiply_out_of_core(fa, fa, fc, 20 * tile_bytes), std::invalid_argument);
+    }
+
+    FileMatrix<double> reopened(pc, 70, 90, 16, FileMode::Open);
+    TEST_CHECK((reopened.load<70, 90>() == *a * *b));
+    TEST_EXCEPTION(FileMatrix<double>(pc, 90, 90, 16, FileMode::Open), std::invalid_argument);
+    TEST_EXCEPTION(FileMatrix<double>((dir / "matrix_test_missing" / "x.bin").string(), 1, 1, 1, FileMode::Open), std::system_error);
+
+    std::filesystem::remove(pa);
+    std::filesystem::remove(pb);
+    std::filesystem::remove(pc);
+}
+
+// Test per-operation counters, merged across threads; the snapshot stays empty when compiled out
+void test_instrumentation()
+{
+    // Arrange
+    instrument::reset();
+    SimpleMatrix<double, 16, 16> a;
+    SimpleMatrix<double, 16, 32> b;
+
+    // Act
+    auto c = a * b;
+    std::thread([&]
+                { auto d = a * b; })
+        .join();
+    auto const entries = instrument::snapshot();
+    std::ostringstream out;
+    instrument::dump(out, entries);
+
+    // Assert
+    if constexpr (!instrument::enabled)
+    {
+        TEST_CHECK(entries.empty());
+        return;
+    }
+    auto it = std::find_if(entries.begin(), entries.end(), [](const instrument::Entry &e)
+                           { return e.op == "multiply" && e.shape == instrument::Shape{16, 32, 16}; });
+    TEST_ASSERT(it != entries.end());
+    TEST_CHECK(it->counters.calls == 2);
+    TEST_CHECK(it->counters.flops == 2 * 2 * 16 * 16 * 32);
+    TEST_CHECK(it->counters.bytes == 2 * (16 * 16 + 16 * 32 + 16 * 32) * sizeof(double));
+    TEST_CHECK(it->counters.allocations == 2); // One result per call.
+    TEST_CHECK(it->counters.allocated_bytes == 2 * 16 * 32 * sizeof(double));
+    TEST_CHECK(out.str().find("multiply") != std::string::npos);
+    instrument::reset();
+    TEST_CHECK(instrument::snapshot().empty());
+}
+
+// Test the documented zero-allocation paths: small fixed-size matrices, in-place operations and row access
+void test_zero_allocation_paths()
+{
+    // Arrange
+    SimpleMatrix<double, 4, 4> a{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    SimpleMatrix<double, 4, 4> b = a * 0.5;
+    SimpleMatrix<double, 3, 5> c;
+    auto big = std::make_unique<SimpleMatrix<float, 64, 64>>();
+    std::iota(big->begin(), big->end(), 0.0f);
+    auto other = std::make_unique<PaddedMatrix<float, 64, 64>>();
+
+    // Act
+    AllocationCounter counter;
+    auto product = a * b;
+    auto total = a + b;
+    auto mixed = a + c;
+    auto joined = a | c;
+    auto scaled = a * 2.0;
+    auto moved = std::move(scaled);
+    auto grown = resize<6, 6>(a);
+    auto flipped = transpose(c);
+    double const s = sum(a);
+    *big += *other;
+    *big *= 2.0f;
+    transpose_inplace(*big);
+    (*big)[3][4] = float(s);
+    float const corner = big->row(63)[63];
+    bool const equal = product == a * b;
+    uint64_t const small_calls = counter.calls();
+
+    AllocationCounter heap;
+    auto big_total = *big + *big;
+
+    // Assert
+    TEST_CHECK(small_calls == 0);
+    TEST_CHECK(counter.bytes() == 64 * 64 * sizeof(float));
+    TEST_CHECK(heap.calls() == 1); // The copy of the left operand, which is returned without another copy.
+    TEST_CHECK(equal);
+    TEST_CHECK(total.at(3, 3) == 24.0);
+    TEST_CHECK(mixed.at(3, 4) == 0.0);
+    TEST_CHECK(joined.at(0, 4) == 0.0);
+    TEST_CHECK(moved.at(0, 0) == 2.0);
+    TEST_CHECK(grown.at(5, 5) == 0.0);
+    TEST_CHECK(flipped.at(4, 2) == 0.0);
+    TEST_CHECK(corner == 2.0f * (64 * 64 - 1));
+    TEST_CHECK(big_total.at(0, 1) == 4.0f * 64);
+}
+
+// Test NUMA placement: large buffers take the policy set at allocation and are first touched in
+// parallel, copies keep their values, and a pinned pool runs every index exactly once.
+void test_numa_placement()
+{
+    // Arrange
+    NumaPolicy const previous = set_numa_policy({NumaMode::Interleave, 0});
+    auto interleaved = std::make_unique<SimpleMatrix<double, 512, 512>>();
+    set_numa_policy(previous);
+    auto local = std::make_unique<SimpleMatrix<double, 512, 512>>();
+    std::iota(local->begin(), local->end(), 0.0);
+    ThreadPool pool(4, true);
+    std::vector<std::atomic<int>> hits(1000);
+
+    // Act
+    *interleaved = *local;
+    auto const copy = std::make_unique<SimpleMatrix<double, 512, 512>>(*interleaved);
+    pool.run(hits.size(), [&](size_t i)
+             { hits[i]++; });
+
+    // Assert
+    TEST_CHECK(numa_nodes().empty() || numa_node_of(interleaved->row(256)) >= 0);
+    TEST_CHECK(numa_nodes().empty() || numa_node_of(local->row(256)) >= 0);
+    TEST_CHECK(interleaved->at(511, 511) == 512.0 * 512 - 1);
+    TEST_CHECK(copy->at(100, 7) == 100.0 * 512 + 7);
+    TEST_CHECK(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int> &h)
+                           { return h == 1; }));
+}
+
+// Test whole-matrix reductions: sum, mean, dot, the three norms and argmin/argmax with ties and NaNs.
+void test_reductions()
+{
+    // Arrange
+    SimpleMatrix<double, 3, 4> m{1, -7, 3, 4,
+                                 5, 6, -7, 8,
+                                 9, 2, 8, 0};
+    SimpleMatrix<double, 3, 4> ones{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    SimpleMatrix<int, 2, 3> ints{3, -1, 4, 1, -5, 9};
+    SimpleMatrix<float, 2, 2> nans{NAN, 2, NAN, 1};
+
+    // Act
+    double const total = sum(m);
+    double const average = mean(m);
+    double const product = dot(m, ones);
+    double const l1 = norm(m, Norm::L1);
+    double const l2 = norm(m);
+    double const inf = norm(m, Norm::Inf);
+    auto const low = argmin(m);
+    auto const high = argmax(m);
+    auto const ints_mean = mean(ints);
+    auto const ints_l2 = norm(ints);
+    auto const nan_max = argmax(nans);
+    float const nan_norm = norm(nans, Norm::Inf);
+
+    // Assert
+    TEST_CHECK(total == 32.0);
+    TEST_CHECK(average == 32.0 / 12);
+    TEST_CHECK(product == 32.0);
+    TEST_CHECK(l1 == 60.0);
+    TEST_CHECK(std::abs(l2 - std::sqrt(398.0)) < 1e-12);
+    TEST_CHECK(inf == 9.0);
+    TEST_CHECK(low.value == -7.0 && low.row == 0 && low.col == 1); // The first of two -7s.
+    TEST_CHECK(high.value == 9.0 && high.row == 2 && high.col == 0);
+    TEST_CHECK((std::is_same_v<decltype(ints_mean), const double>));
+    TEST_CHECK(ints_mean == 11.0 / 6);
+    TEST_CHECK(std::abs(ints_l2 - std::sqrt(133.0)) < 1e-12);
+    TEST_CHECK(nan_max.value == 2.0f && nan_max.row == 0 && nan_max.col == 1);
+    TEST_CHECK(std::isnan(nan_norm));
+}
+
+// Test per-row and per-column reductions on padded and half-precision matrices, large enough to run in
+// parallel, against scalar loops.
+void test_axis_reductions()
+{
+    // Arrange
+    constexpr size_t R = 300, C = 500;
+    auto m = std::make_unique<PaddedMatrix<double, R, C>>();
+    auto h = std::make_unique<SimpleMatrix<half, R, C>>();
+    for (size_t r{0}; r < R; r++)
+    {
+        for (size_t c{0}; c < C; c++)
+        {
+            (*m)[r][c] = double((r * 7 + c * 13) % 31) - 15.0;
+            (*h)[r][c] = half(float((r + c) % 5));
+        }
+    }
+
+    // Act
+    auto const rs = row_sums(*m);
+    auto const cs = col_sums(*m, Summation::Kahan);
+    auto const rm = row_means(*m);
+    auto const cm = col_means(*m, Summation::Pairwise);
+    auto const rd = row_dots(*m, *m);
+    auto const cd = col_dots(*m, *m);
+    auto const rn = row_norms(*m, Norm::L1);
+    auto const cn = col_norms(*m, Norm::Inf);
+    auto const rmax = row_argmax(*m);
+    auto const cmin = col_argmin(*m);
+    auto const hs = col_sums(*h);
+    float const hsum = sum(*h, Summation::Pairwise);
+    auto const hmax = argmax(*h);
+
+    // Assert
+    bool rows_ok{true};
+    for (size_t r{0}; r < R; r++)
+    {
+        double s{0}, sq{0}, l1{0}, best{-1e9};
+        size_t at{0};
+        for (size_t c{0}; c < C; c++)
+        {
+            double const v = m->at(r, c);
+            s += v;
+            sq += v * v;
+            l1 += std::abs(v);
+            at = v > best ? c : at;
+            best = std::max(best, v);
+        }
+        rows_ok = rows_ok && rs.at(r, 0) == s && rm.at(r, 0) == s / C && rd.at(r, 0) == sq && rn.at(r, 0) == l1;
+        rows_ok = rows_ok && rmax.values.at(r, 0) == best && rmax.indices.at(r, 0) == at;
+    }
+    bool cols_ok{true};
+    for (size_t c{0}; c < C; c++)
+    {
+        double s{0}, sq{0}, inf{0}, least{1e9};
+        size_t at{0};
+        float hc{0};
+        for (size_t r{0}; r < R; r++)
+        {
+            double const v = m->at(r, c);
+            s += v;
+            sq += v * v;
+            inf = std::max(inf, std::abs(v));
+            at = v < least ? r : at;
+            least = std::min(least, v);
+            hc += float(h->at(r, c));
+        }
+        cols_ok = cols_ok && cs.at(0, c) == s && cm.at(0, c) == s / R && cd.at(0, c) == sq && cn.at(0, c) == inf;
+        cols_ok = cols_ok && cmin.values.at(0, c) == least && cmin.indices.at(0, c) == at && hs.at(0, c) == hc;
+    }
+    TEST_CHECK(rows_ok);
+    TEST_CHECK(cols_ok);
+    TEST_CHECK(hsum == 300000.0f);
+    TEST_CHECK(float(hmax.value) == 4.0f && hmax.row == 0 && hmax.col == 4);
+}
+
+// Test compensated summation: a large float sum whose plain result drifts is exact enough with Kahan
+// and pairwise summation, and the result does not depend on the block split.
+void test_compensated_summation()
+{
+    // Arrange
+    auto m = std::make_unique<SimpleMatrix<float, 1024, 1024>>();
+    std::fill(m->begin(), m->end(), 0.1f);
+    (*m)[0][0] = 1e6f;
+    double const exact = 1e6 + (1024.0 * 1024 - 1) * double(0.1f);
+
+    // Act
+    float const plain = sum(*m);
+    float const kahan = sum(*m, Summation::Kahan);
+    float const pairwise = sum(*m, Summation::Pairwise);
+    float const again = sum(*m, Summation::Kahan);
+    auto const columns = col_sums(*m, Summation::Kahan);
+
+    // Assert
+    double const ulp = std::nextafter(float(exact), 2e6f) - float(exact);
+    TEST_CHECK(std::abs(kahan - exact) <= ulp);
+    TEST_CHECK(std::abs(pairwise - exact) <= 4 * ulp);
+    TEST_CHECK(std::abs(kahan - exact) <= std::abs(plain - exact));
+    TEST_CHECK(kahan == again);
+    TEST_CHECK(std::abs(columns.at(0, 1) - 1024 * 0.1f) <= 1e-4f);
+}
+
+// Test map and zip_with: every policy gives the same result on a matrix large enough to be split across
+// threads, the result takes the lambda's element type, and padded operands are walked row by row.
+void test_map_zip_with()
+{
+    // Arrange
+    auto a = std::make_unique<SimpleMatrix<float, 300, 500>>();
+    auto b = std::make_unique<SimpleMatrix<float, 300, 500>>();
+    std::iota(a->begin(), a->end(), -75000.0f);
+    std::fill(b->begin(), b->end(), 0.5f);
+    auto relu = [](float x)
+    { return x > 0 ? x : 0.0f; };
+    PaddedMatrix<int, 3, 5> p;
+    for (size_t i{0}; i < 3; i++)
+    {
+        std::iota(p.row(i), p.row(i) + 5, int(10 * i));
+    }
+
+    // Act
+    auto const seq = map(execution::seq, *a, relu);
+    auto const unseq = map(execution::unseq, *a, relu);
+    auto const par = map(execution::par, *a, relu);
+    auto const par_unseq = map(*a, relu);
+    auto const fma = zip_with(*a, *b, [](float x, float y)
+                              { return double(x) * y + 1; });
+    auto const halves = map(execution::seq, p, [](int x)
+                            { return x / 2.0; });
+
+    // Assert
+    TEST_CHECK(seq.at(0, 0) == 0.0f && seq.at(299, 499) == 74999.0f && seq.at(150, 1) == 1.0f);
+    TEST_CHECK(unseq == seq);
+    TEST_CHECK(par == seq);
+    TEST_CHECK(par_unseq == seq);
+    TEST_CHECK((std::is_same_v<decltype(fma), const SimpleMatrix<double, 300, 500>>));
+    TEST_CHECK(fma.at(0, 0) == -37499.0 && fma.at(299, 499) == 37500.5);
+    TEST_CHECK((std::is_same_v<decltype(halves), const PaddedMatrix<double, 3, 5>>));
+    TEST_CHECK(halves.at(2, 3) == 11.5 && halves.at(0, 1) == 0.5);
+}
+
+// Test the in-place variants: they rewrite the operand without allocating, including when both
+// operands of zip_with_inplace are the same matrix.
+void test_map_inplace()
+{
+    // Arrange
+    auto a = std::make_unique<SimpleMatrix<double, 300, 500>>();
+    auto b = std::make_unique<PaddedMatrix<double, 300, 500>>();
+    std::iota(a->begin(), a->end(), 0.0);
+    for (size_t i{0}; i < 300; i++)
+    {
+        std::fill(b->row(i), b->row(i) + 500, double(i));
+    }
+    SimpleMatrix<int, 2, 2> small{1, 2, 3, 4};
+    AllocationCounter counter;
+
+    // Act
+    map_inplace(*a, [](double x)
+                { return std::min(x, 1000.0); });
+    zip_with_inplace(execution::par, *a, *b, [](double x, double y)
+                     { return x - y; });
+    zip_with_inplace(execution::unseq, small, small, [](int x, int y)
+                     { return x * y; });
+    auto const calls = counter.calls();
+
+    // Assert
+    TEST_CHECK(calls == 0);
+    TEST_CHECK(a->at(0, 7) == 7.0 && a->at(1, 2) == 501.0 && a->at(2, 0) == 1000.0 - 2 && a->at(299, 499) == 1000.0 - 299);
+    TEST_CHECK(small == (SimpleMatrix<int, 2, 2>{1, 4, 9, 16}));
+}
+
+// Test broadcasting: a row vector repeats down the rows, a column vector across the columns, a column
+// with a row gives their outer combination, and centering in place does not allocate.
+void test_broadcasting()
+{
+    // Arrange
+    auto points = std::make_unique<SimpleMatrix<double, 300, 3>>();
+    for (size_t i{0}; i < 300; i++)
+    {
+        points->row(i)[0] = double(i);
+        points->row(i)[1] = 2.0 * double(i) + 5;
+        points->row(i)[2] = -1.0;
+    }
+    auto m = std::make_unique<PaddedMatrix<float, 300, 500>>();
+    for (size_t i{0}; i < 300; i++)
+    {
+        std::iota(m->row(i), m->row(i) + 500, float(i));
+    }
+    SimpleMatrix<float, 300, 1> weights;
+    std::iota(weights.begin(), weights.end(), 0.0f);
+    SimpleMatrix<float, 1, 500> offsets;
+    std::fill(offsets.begin(), offsets.end(), 1.0f);
+    SimpleMatrix<int, 3, 1> u{1, 2, 3};
+    SimpleMatrix<int, 1, 4> v{1, 10, 100, 1000};
+    auto const means = col_means(*points);
+    AllocationCounter counter;
+
+    // Act
+    zip_with_inplace(*points, means, std::minus<>{});
+    auto const centering_calls = counter.calls();
+    auto const scaled = zip_with(*m, weights, std::multiplies<>{});
+    auto const shifted = zip_with(execution::seq, offsets, *m, std::minus<>{});
+    auto const outer = zip_with(u, v, std::multiplies<>{});
+
+    // Assert
+    TEST_CHECK(centering_calls == 0);
+    TEST_CHECK(points->at(0, 0) == -149.5 && points->at(299, 1) == 299.0 && points->at(7, 2) == 0.0);
+    TEST_CHECK((std::is_same_v<decltype(scaled), const PaddedMatrix<float, 300, 500>>));
+    TEST_CHECK(scaled.at(2, 3) == 10.0f && scaled.at(299, 499) == 299.0f * 798.0f);
+    TEST_CHECK(shifted.at(0, 0) == 1.0f && shifted.at(4, 6) == -9.0f);
+    TEST_CHECK(outer == (SimpleMatrix<int, 3, 4>{1, 10, 100, 1000, 2, 20, 200, 2000, 3, 30, 300, 3000}));
+}
+
+// Test row and column ranges: both are sized random-access ranges, rows are contiguous spans, and
+// algorithms work down a column in place.
+void test_row_col_ranges()
+{
+    // Arrange
+    auto m = createSampleMatrix();
+    PaddedMatrix<float, 4, 3> p;
+    for (size_t i{0}; i < 4; i++)
+    {
+        std::fill(p.row(i), p.row(i) + 3, float(4 - i));
+    }
+    const auto &cm = m;
+
+    // Act
+    auto r = rows(cm);
+    auto c = cols(m);
+    std::vector<int> totals;
+    for (auto row : r)
+    {
+        totals.push_back(std::accumulate(row.begin(), row.end(), 0));
+    }
+    std::ranges::sort(c[1]);
+    std::ranges::sort(cols(p)[2]);
+    std::ranges::fill(rows(p)[0], 9.0f);
+
+    // Assert
+    TEST_CHECK(std::ranges::random_access_range<decltype(r)> && std::ranges::sized_range<decltype(r)> && std::ranges::view<decltype(r)>);
+    TEST_CHECK((std::is_same_v<std::iterator_traits<decltype(r.begin())>::iterator_category, std::input_iterator_tag>));
+    TEST_CHECK(std::ranges::random_access_range<decltype(c[0])> && std::contiguous_iterator<decltype(r[0].begin())>);
+    TEST_CHECK(r.size() == 3 && c.size() == 5 && r.end() - r.begin() == 3);
+    TEST_CHECK((totals == std::vector<int>{10, 35, 30}));
+    TEST_CHECK(m.at(0, 1) == 1 && m.at(1, 1) == 6 && m.at(2, 1) == 7 && m.at(1, 4) == 9);
+    TEST_CHECK(p.at(0, 2) == 9.0f && p.at(1, 2) == 2.0f && p.at(3, 2) == 4.0f && p.at(0, 0) == 9.0f);
+}
+
+// Test tiles: edge tiles are cut to the matrix, every element belongs to exactly one tile, and tiles
+// can be filled concurrently with parallel_for_each.
+void test_tiles()
+{
+    // Arrange
+    auto m = std::make_unique<PaddedMatrix<int, 300, 500>>();
+    SimpleMatrix<int, 5, 7> small;
+
+    // Act
+    auto const t = tiles<2, 3>(small);
+    parallel_for_each(tiles(*m), [](Tile<int> tile)
+                      {
+                          for (size_t i{0}; i < tile.rows; i++)
+                          {
+                              for (size_t j{0}; j < tile.cols; j++)
+                              {
+                                  tile(i, j) = int((tile.row0 + i) * 1000 + tile.col0 + j);
+                              }
+                          } });
+    size_t covered{0};
+    for (auto tile : t)
+    {
+        covered += tile.rows * tile.cols;
+    }
+
+    // Assert
+    TEST_CHECK(t.size() == 9 && t[8].row0 == 4 && t[8].col0 == 6 && t[8].rows == 1 && t[8].cols == 1);
+    TEST_CHECK(t[4].row0 == 2 && t[4].col0 == 3 && t[4].row(1).size() == 3 && &t[4](1, 0) == &small.row(3)[3]);
+    TEST_CHECK(covered == 35);
+    TEST_CHECK(default_tile<float> == 64 && tiles(*m).size() == 5 * 8);
+    bool all{true};
+    for (size_t i{0}; i < 300; i++)
+    {
+        for (size_t j{0}; j < 500; j++)
+        {
+            all = all && m->at(i, j) == int(i * 1000 + j);
+        }
+    }
+    TEST_CHECK(all);
+}
+
+// Test copy-on-write storage: copies share the buffer without allocating, the first write detaches
+// only the written copy, and results of operations on shared matrices are shared matrices.
+void test_copy_on_write()
+{
+    // Arrange
+    SharedMatrix<float, 300, 500> a;
+    std::iota(a.begin(), a.end(), 0.0f);
+    const auto &ca = a;
+    SharedMatrix<float, 300, 500> c;
+    AllocationCounter counter;
+
+    // Act
+    SharedMatrix<float, 300, 500> b = a;
+    c = b;
+    bool const shared = ca.data() == std::as_const(b).data() && ca.data() == std::as_const(c).data();
+    auto const sharing_calls = counter.calls();
+    b[1][2] = -1.0f;
+    auto const detach_calls = counter.calls();
+    map_inplace(c, [](float x)
+                { return x + 1; });
+    auto const sum = a + a;
+
+    // Assert
+    TEST_CHECK(shared);
+    TEST_CHECK(sharing_calls == 0);
+    TEST_CHECK(detach_calls == 1);
+    TEST_CHECK(ca.data() != std::as_const(b).data() && ca.data() != std::as_const(c).data());
+    TEST_CHECK(a.at(1, 2) == 502.0f && b.at(1, 2) == -1.0f && c.at(1, 2) == 503.0f && b.at(299, 499) == 149999.0f);
+    TEST_CHECK((std::is_same_v<decltype(sum), const SharedMatrix<float, 300, 500>>));
+    TEST_CHECK(sum.at(1, 2) == 1004.0f);
+}
+
+// Test matrix-vector kernels: gemv, gemv_transposed and rank1_update against a plain reference, on
+// shapes large enough to split across threads and odd enough to leave tails, and the operator*
+// dispatch to them when one dimension is 1.
+void test_gemv()
+{
+    // Arrange
+    auto a = std::make_unique<SimpleMatrix<int, 301, 517>>();
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(-9, 9);
+    std::generate(a->begin(), a->end(), [&]
+                  { return dist(gen); });
+    SimpleMatrix<int, 517, 1> x;
+    PaddedMatrix<int, 301, 1> xt; // Strided vector: one element per padded row.
+    std::generate(x.begin(), x.end(), [&]
+                  { return dist(gen); });
+    for (size_t i{0}; i < 301; i++)
+    {
+        xt.row(i)[0] = dist(gen);
+    }
+    SimpleMatrix<int, 1, 301> xt_row;
+    for (size_t i{0}; i < 301; i++)
+    {
+        xt_row.row(0)[i] = xt.at(i, 0);
+    }
+    SimpleMatrix<int, 3, 1> u{1, 2, 3};
+    SimpleMatrix<int, 1, 4> v{1, 10, 100, 1000};
+    SimpleMatrix<int, 4, 1> vt{1, 10, 100, 1000};
+    SimpleMatrix<int, 3, 4> r{};
+
+    // Act
+    auto const y = gemv(*a, x);
+    auto const y_op = *a * x;
+    auto const yt = gemv_transposed(*a, xt);
+    auto const yt_op = xt_row * *a;
+    auto const outer = u * v;
+    rank1_update(r, 2, u, vt);
+
+    // Assert
+    bool matches{true};
+    for (size_t i{0}; i < 301; i++)
+    {
+        int expected{0};
+        for (size_t k{0}; k < 517; k++)
+        {
+            expected += a->at(i, k) * x.at(k, 0);
+        }
+        matches = matches && y.at(i, 0) == expected;
+    }
+    for (size_t j{0}; j < 517; j++)
+    {
+        int expected{0};
+        for (size_t i{0}; i < 301; i++)
+        {
+            expected += a->at(i, j) * xt.at(i, 0);
+        }
+        matches = matches && yt.at(j, 0) == expected && yt_op.at(0, j) == expected;
+    }
+    TEST_CHECK(matches);
+    TEST_CHECK(y_op == y);
+    TEST_CHECK((outer == SimpleMatrix<int, 3, 4>{1, 10, 100, 1000, 2, 20, 200, 2000, 3, 30, 300, 3000}));
+    TEST_CHECK((r == SimpleMatrix<int, 3, 4>{2, 20, 200, 2000, 4, 40, 400, 4000, 6, 60, 600, 6000}));
+}
+
+// Test triangular multiply and solve (TRSM and TRSV) for both triangles and a unit diagonal, across
+// several solve blocks, against the dense path
+void test_triangular()
+{
+    // Arrange
+    constexpr size_t N = 150;
+    auto const dense = createSpdMatrix<N>(11);
+    auto const scaled = map(dense, [](double v)
+                            { return v / double(N); });
+    TriangularMatrix<double, N, Triangle::Lower> lower(dense);
+    TriangularMatrix<double, N, Triangle::Upper> upper(dense);
+    TriangularMatrix<double, N, Triangle::Lower, Diagonal::Unit> unit(scaled);
+    SimpleMatrix<double, N, 3> x;
+    PaddedMatrix<double, N, 1> v; // Strided single column.
+    for (size_t i = 0; i < N; i++)
+    {
+        x[i][0] = double(i);
+        x[i][1] = 1.0 - double(i % 7);
+        x[i][2] = 0.5;
+        v.row(i)[0] = double(i % 5);
+    }
+
+    // Act
+    auto const bl = lower * x;
+    auto const bu = upper * x;
+    auto const bn = unit * x;
+    auto bv = upper * v;
+    triangular_solve_inplace(upper, bv);
+    auto expiring = lower * x;
+    double const *storage = expiring.data();
+    auto reused = triangular_solve(lower, std::move(expiring));
+
+    // Assert
+    TEST_CHECK(approxEqual(bl, lower.dense() * x));
+    TEST_CHECK(approxEqual(bu, upper.dense() * x));
+    TEST_CHECK(approxEqual(bn, unit.dense() * x));
+    TEST_CHECK(approxEqual(triangular_solve(lower, bl), x));
+    TEST_CHECK(approxEqual(triangular_solve(upper, bu), x));
+    TEST_CHECK(approxEqual(triangular_solve(unit, bn), x));
+    TEST_CHECK(reused.data() == storage && approxEqual(reused, x)); // Solved in place of the rvalue.
+    bool column_solved{true};
+    for (size_t i = 0; i < N; i++)
+    {
+        column_solved = column_solved && std::abs(bv.at(i, 0) - v.at(i, 0)) < 1e-9;
+    }
+    TEST_CHECK(column_solved);
+    TEST_CHECK(lower.at(0, 1) == 0.0 && upper.at(1, 0) == 0.0 && unit.at(5, 5) == 1.0);
+    TEST_CHECK(lower.at(7, 3) == dense.at(7, 3) && upper.at(3, 7) == dense.at(3, 7));
+    TEST_EXCEPTION(lower.element(0, 1) = 1.0, std::out_of_range);
+
+    SymmetricMatrix<double, 3> a{
+        4,
+        12, 37,
+        -16, -43, 98};
+    TriangularMatrix<double, 3> l(cholesky(a));
+    TEST_CHECK((l == TriangularMatrix<double, 3>{2, 6, 1, -8, 5, 3}));
+}
+
+// Test banded storage, conversions, multiply and triangular banded solves, including a rectangular
+// band whose last rows lie entirely outside the matrix
+void test_banded()
+{
+    // Arrange
+    constexpr size_t N = 200;
+    auto const dense = createSpdMatrix<N>(5);
+    BandedMatrix<double, N, N, 2, 1> band(dense);
+    BandedMatrix<double, N, N, 2, 0> lower(dense);
+    BandedMatrix<double, N, N, 0, 3> upper(dense);
+    BandedMatrix<double, 5, 3, 1, 0> tall(SimpleMatrix<double, 5, 3>{
+        1, 9, 9,
+        2, 3, 9,
+        9, 4, 5,
+        9, 9, 6,
+        9, 9, 9});
+    SimpleMatrix<double, N, 2> x;
+    for (size_t i = 0; i < N; i++)
+    {
+        x[i][0] = double(i);
+        x[i][1] = 1.0 - double(i % 7);
+    }
+    SimpleMatrix<double, N, 1> y;
+    std::iota(y.begin(), y.end(), 1.0);
+
+    // Act
+    auto const bx = band * x;
+    auto const lx = lower * x;
+    auto const uy = upper * y;
+    auto expiring = upper * y;
+    double const *storage = expiring.data();
+    auto reused = triangular_solve(upper, std::move(expiring));
+    auto const tall_x = tall * SimpleMatrix<double, 3, 1>{1, 10, 100};
+
+    // Assert
+    bool in_band{true};
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t j = 0; j < N; j++)
+        {
+            double const expected = j + 2 >= i && j <= i + 1 ? dense.at(i, j) : 0.0;
+            in_band = in_band && band.at(i, j) == expected;
+        }
+    }
+    TEST_CHECK(in_band);
+    TEST_CHECK(approxEqual(bx, band.dense() * x));
+    TEST_CHECK(approxEqual(triangular_solve(lower, lx), x));
+    TEST_CHECK(approxEqual(triangular_solve(upper, uy), y));
+    TEST_CHECK(reused.data() == storage && approxEqual(reused, y));
+    TEST_CHECK((tall.dense() == SimpleMatrix<double, 5, 3>{1, 0, 0, 2, 3, 0, 0, 4, 5, 0, 0, 6, 0, 0, 0}));
+    TEST_CHECK((tall_x == SimpleMatrix<double, 5, 1>{1, 32, 540, 600, 0}));
+    TEST_CHECK((BandedMatrix<double, N, N, 2, 1>(band.dense()) == band));
+    TEST_EXCEPTION(band.element(0, 2) = 1.0, std::out_of_range);
+}
+
+// Test pairwise squared distances in both modes against a direct reference, across several column
+// tiles, in low and high dimension
+void test_pairwise_distances()
+{
+    // Arrange
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<double> dist(-10.0, 10.0);
+    auto a = std::make_unique<SimpleMatrix<double, 37, 3>>();
+    auto b = std::make_unique<SimpleMatrix<double, 2100, 3>>();
+    auto p = std::make_unique<SimpleMatrix<double, 20, 24>>();
+    auto q = std::make_unique<SimpleMatrix<double, 300, 24>>(); // Two tiles of distance_tile<double, 24> points.
+    std::generate(a->begin(), a->end(), [&]
+                  { return dist(gen); });
+    std::generate(b->begin(), b->end(), [&]
+                  { return dist(gen); });
+    std::generate(p->begin(), p->end(), [&]
+                  { return dist(gen); });
+    std::generate(q->begin(), q->end(), [&]
+                  { return dist(gen); });
+    for (size_t d = 0; d < 3; d++)
+    {
+        (*b)[5][d] = (*a)[0][d]; // A point of A that B contains.
+    }
+
+    // Act
+    auto const direct = pairwise_squared_distances(*a, *b);
+    auto const gemm = pairwise_squared_distances(*a, *b, DistanceMode::Gemm);
+    auto const high = pairwise_squared_distances(*p, *q);
+
+    // Assert
+    auto reference = [](const auto &x, const auto &y, size_t i, size_t j, size_t dims)
+    {
+        double sum{0};
+        for (size_t d = 0; d < dims; d++)
+        {
+            sum += (x.at(i, d) - y.at(j, d)) * (x.at(i, d) - y.at(j, d));
+        }
+        return sum;
+    };
+    bool direct_ok{true}, gemm_ok{true}, high_ok{true};
+    for (size_t i = 0; i < 37; i++)
+    {
+        for (size_t j = 0; j < 2100; j++)
+        {
+            double const expected = reference(*a, *b, i, j, 3);
+            direct_ok = direct_ok && std::abs(direct.at(i, j) - expected) <= 1e-9 * (1.0 + expected);
+            gemm_ok = gemm_ok && gemm.at(i, j) >= 0.0 && std::abs(gemm.at(i, j) - expected) <= 1e-9 * (1.0 + expected);
+        }
+    }
+    for (size_t i = 0; i < 20; i++)
+    {
+        for (size_t j = 0; j < 300; j++)
+        {
+            double const expected = reference(*p, *q, i, j, 24);
+            high_ok = high_ok && std::abs(high.at(i, j) - expected) <= 1e-9 * (1.0 + expected);
+        }
+    }
+    TEST_CHECK(direct_ok);
+    TEST_CHECK(gemm_ok);
+    TEST_CHECK(high_ok);
+    TEST_CHECK(direct.at(0, 5) == 0.0);
+    TEST_CHECK((distance_tile<double, 24> == 160 && distance_tile<float, 3> == 2720));
+}
+
+// Test that the fused top-k search matches a full sort of the distances, keeps the lower index on
+// ties, and reduces to the argmin for K = 1
+void test_nearest_neighbors()
+{
+    // Arrange
+    std::mt19937 gen(23);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto a = std::make_unique<SimpleMatrix<float, 150, 3>>();
+    auto b = std::make_unique<SimpleMatrix<float, 2500, 3>>();
+    std::generate(a->begin(), a->end(), [&]
+                  { return dist(gen); });
+    std::generate(b->begin(), b->end(), [&]
+                  { return dist(gen); });
+    for (size_t d = 0; d < 3; d++)
+    {
+        (*b)[2400][d] = (*b)[7][d]; // The same point twice in B, and once in A.
+        (*a)[3][d] = (*b)[7][d];
+    }
+
+    // Act
+    auto const knn = nearest_neighbors<4>(*a, *b);
+    auto const nearest = nearest_neighbors(*a, *b);
+    auto const distances = pairwise_squared_distances(*a, *b);
+
+    // Assert
+    bool sorted_ok{true};
+    for (size_t i = 0; i < 150; i++)
+    {
+        std::vector<size_t> order(2500);
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y)
+                         { return distances.at(i, x) < distances.at(i, y); });
+        for (size_t k = 0; k < 4; k++)
+        {
+            sorted_ok = sorted_ok && knn.index.at(i, k) == order[k] && knn.distance.at(i, k) == distances.at(i, order[k]);
+        }
+        sorted_ok = sorted_ok && nearest.index.at(i, 0) == order[0];
+    }
+    TEST_CHECK(sorted_ok);
+    TEST_CHECK(knn.index.at(3, 0) == 7 && knn.index.at(3, 1) == 2400 && knn.distance.at(3, 1) == 0.0f);
+}
+
+// Test streaming covariance against a two-pass reference in double on float samples far from the
+// origin, in one pass, in pieces, merged from two accumulators and from an external strided buffer
+void test_covariance()
+{
+    // Arrange
+    constexpr size_t N = 100000;
+    std::mt19937 gen(31);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    auto samples = std::make_unique<SimpleMatrix<float, N, 3>>();
+    for (size_t i = 0; i < N; i++)
+    {
+        float const t = noise(gen);
+        (*samples)[i][0] = 10000.0f + t;
+        (*samples)[i][1] = -5000.0f + 2.0f * t + 0.5f * noise(gen);
+        (*samples)[i][2] = 20000.0f + noise(gen);
+    }
+    std::vector<float> buffer(N * 4); // Rows of 3 samples padded to 4.
+    for (size_t i = 0; i < N; i++)
+    {
+        std::copy(samples->row(i), samples->row(i) + 3, buffer.data() + 4 * i);
+    }
+    double mean[3]{};
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t p = 0; p < 3; p++)
+        {
+            mean[p] += double(samples->at(i, p)) / double(N);
+        }
+    }
+    std::vector<double> wide(1000 * 512); // 2 MiB of co-moments per accumulator, merged across threads.
+    for (size_t i = 0; i < wide.size(); i++)
+    {
+        wide[i] = double((i * 7919) % 101);
+    }
+    double expected[3][3]{};
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t p = 0; p < 3; p++)
+        {
+            for (size_t q = 0; q < 3; q++)
+            {
+                expected[p][q] += (samples->at(i, p) - mean[p]) * (samples->at(i, q) - mean[q]) / double(N - 1);
+            }
+        }
+    }
+
+    // Act
+    auto const whole = covariance(*samples);
+    CovarianceAccumulator<float, 3> pieces;
+    pieces.add(samples->data(), 1000);
+    pieces.add(samples->data() + 3 * 1000, 333);
+    pieces.add(samples->data() + 3 * 1333, N - 1333);
+    CovarianceAccumulator<double, 3> first, second;
+    first.add(buffer.data(), N / 2, 4);
+    second.add(buffer.data() + 4 * (N / 2), N - N / 2, 4);
+    first.merge(second);
+    CovarianceAccumulator<double, 512> high;
+    high.add(wide.data(), 1000);
+    auto const high_covariance = high.covariance();
+
+    // Assert
+    auto reference = [&](size_t p, size_t q)
+    {
+        double mp{0}, mq{0}, c{0};
+        for (size_t i = 0; i < 1000; i++)
+        {
+            mp += wide[i * 512 + p] / 1000.0;
+            mq += wide[i * 512 + q] / 1000.0;
+        }
+        for (size_t i = 0; i < 1000; i++)
+        {
+            c += (wide[i * 512 + p] - mp) * (wide[i * 512 + q] - mq) / 999.0;
+        }
+        return c;
+    };
+    auto close = [&](const auto &c, double tolerance)
+    {
+        bool ok{true};
+        for (size_t p = 0; p < 3; p++)
+        {
+            for (size_t q = 0; q < 3; q++)
+            {
+                ok = ok && std::abs(double(c.at(p, q)) - expected[p][q]) <= tolerance * (1.0 + std::abs(expected[p][q]));
+            }
+        }
+        return ok;
+    };
+    TEST_CHECK(close(whole, 1e-3));
+    TEST_CHECK(close(pieces.covariance(), 1e-3));
+    TEST_CHECK(close(first.covariance(), 1e-9));
+    TEST_CHECK(first.count() == N && pieces.count() == N);
+    TEST_CHECK(std::abs(first.mean().at(0, 1) - mean[1]) < 1e-9);
+    TEST_CHECK(std::abs(first.covariance(0).at(2, 2) * double(N) - expected[2][2] * double(N - 1)) < 1e-6 * double(N));
+    CovarianceAccumulator<double, 3> const empty;
+    TEST_EXCEPTION(empty.covariance(), std::domain_error);
+    TEST_EXCEPTION(first.add(buffer.data(), 1, 2), std::invalid_argument);
+    TEST_CHECK(std::abs(high_covariance.at(0, 511) - reference(0, 511)) < 1e-9 * (1.0 + std::abs(reference(0, 511))));
+    TEST_CHECK(std::abs(high_covariance.at(300, 7) - reference(7, 300)) < 1e-9 * (1.0 + std::abs(reference(7, 300))));
+    TEST_CHECK(std::abs(high_covariance.at(42, 42) - reference(42, 42)) < 1e-9 * (1.0 + reference(42, 42)));
+}
+
+// Test that views run library operations on a foreign buffer without allocating, that copies of a view
+// are independent owned matrices, and that a strided view is written and read in place
+void test_external_view()
+{
+    // Arrange
+    constexpr size_t R = 480, C = 640;
+    std::vector<float> frame(R * C);
+    std::iota(frame.begin(), frame.end(), 0.0f);
+    std::vector<float> strided(4 * 5, -1.0f); // 4 rows of 3 elements, 5 apart.
+    SimpleMatrix<float, 4, 3> small{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    AllocationCounter counter;
+
+    // Act
+    auto v = view<R, C>(frame.data());
+    map_inplace(v, [](float x)
+                { return x * 2.0f; });
+    v *= 0.5f;
+    auto const largest = argmax(v);
+    auto s = view<4, 3, 5>(std::span(strided));
+    s = small;
+    auto const view_calls = counter.calls();
+    auto copy = v;
+    copy[0][1] = -1.0f;
+    auto const product = s * SimpleMatrix<float, 3, 1>{1, 1, 1};
+    AllocationCounter sum_counter;
+    auto const doubled = v + v;
+    auto const sum_calls = sum_counter.calls();
+    auto const scaled = s * 2.0f;
+
+    // Assert
+    TEST_CHECK(view_calls == 0);
+    TEST_CHECK(v.data() == frame.data() && copy.data() != frame.data());
+    TEST_CHECK(frame[1] == 1.0f && copy.at(0, 1) == -1.0f && copy.at(R - 1, C - 1) == float(R * C - 1));
+    TEST_CHECK(largest.value == float(R * C - 1) && largest.row == R - 1 && largest.col == C - 1);
+    TEST_CHECK(strided[5] == 4.0f && strided[3] == -1.0f && strided[15 + 2] == 12.0f);
+    TEST_CHECK((product == SimpleMatrix<float, 4, 1>{6, 15, 24, 33}));
+    TEST_CHECK((std::is_same_v<decltype(product), const SimpleMatrix<float, 4, 1>>));
+    TEST_CHECK((std::is_same_v<decltype(v + v), SimpleMatrix<float, R, C>>));
+    TEST_CHECK((std::is_same_v<decltype(scaled), const SimpleMatrix<float, 4, 3>>));
+    TEST_CHECK(sum_calls == 1 && doubled.at(R - 1, C - 1) == 2.0f * float(R * C - 1) && scaled.at(1, 0) == 8.0f);
+    TEST_EXCEPTION((view<R, C>(std::span(frame).first(10))), std::invalid_argument);
+    TEST_CHECK((view<0, C>(std::span(frame).first(0)).data() == frame.data()));
+}
+
+// Test that an adopted buffer is used in place and released once by its deleter, after moves
+void test_adopted_buffer()
+{
+    // Arrange
+    int releases{0};
+    float *buffer = new float[6]{1, 2, 3, 4, 5, 6};
+
+    // Act
+    {
+        auto m = adopt<2, 3>(buffer, [&](float *p)
+                             { delete[] p; releases++; });
+        auto moved = std::move(m);
+        moved *= 2.0f;
+
+        // Assert
+        TEST_CHECK(moved.data() == buffer && moved.at(1, 2) == 12.0f);
+        TEST_CHECK(releases == 0);
+    }
+    TEST_CHECK(releases == 1);
+}
+
+// Test the t quantiles against table values and Welch's interval on fixed samples
+void test_bench_statistics()
+{
+    // Arrange
+    std::vector<double> const a{1, 2, 3, 4, 5};
+    std::vector<double> const b{2, 4, 6, 8, 10};
+    std::vector<double> const flat{7, 7, 7};
+
+    // Act
+    bench::Interval const diff = bench::welch95(a, b);
+    bench::Interval const exact = bench::welch95(flat, flat);
+    bench::Interval const single = bench::welch95({1.0}, b);
+
+    // Assert
+    auto near = [](double x, double expected, double tolerance)
+    { return std::abs(x - expected) <= tolerance * expected; };
+    TEST_CHECK(near(bench::student_t95(3), 3.182446, 0.01));
+    TEST_CHECK(near(bench::student_t95(10), 2.228139, 0.001));
+    TEST_CHECK(near(bench::student_t95(30), 2.042272, 0.001));
+    TEST_CHECK(std::isinf(bench::student_t95(0.5)));
+    // Variances 2.5 and 10 give 100/17 degrees of freedom, t = 2.458, and a standard error of sqrt(2.5).
+    TEST_CHECK(diff.estimate == 3.0);
+    TEST_CHECK(near(diff.half_width, 2.458 * std::sqrt(2.5), 0.01));
+    TEST_CHECK(diff.lower() < 0 && diff.upper() > 6);
+    TEST_CHECK(exact.estimate == 0.0 && exact.half_width == 0.0);
+    TEST_CHECK(std::isinf(single.half_width));
+}
+
+// Test benchmark results survive a JSON round trip and only a significant slowdown is a regression
+void test_bench_baseline()
+{
+    // Arrange
+    std::vector<bench::Result> const baseline{
+        {"multiply 64", 4096, 524288, 10, 1.0, {1.0, 1.01, 0.99, 1.0, 1.0}, {{"cycles", 1.5e9}}},
+        {"noisy", 1, 0, 1, 1.0, {0.9, 1.1, 1.0, 0.95, 1.05}, {}},
+        {"add \"quoted\"", 1, 1, 3, 0.25, {0.25}, {}}};
+    std::vector<bench::Result> const current{
+        {"multiply 64", 4096, 524288, 10, 1.2, {1.2, 1.21, 1.19, 1.2, 1.2}, {}},
+        {"noisy", 1, 0, 1, 1.3, {0.6, 2.0, 1.3, 0.7, 1.9}, {}},
+        {"multiply 32", 1024, 65536, 10, 0.5, {0.5, 0.5}, {}}};
+    std::vector<bench::Tolerance> const rules{{"multiply", 0.3}, {"multiply 64", 0.1}};
+
+    // Act
+    std::stringstream stream;
+    bench::write_json(stream, baseline);
+    auto const restored = bench::read_json(stream);
+    auto const verdicts = bench::compare(restored, current, rules, 0.05);
+    auto const faster = bench::compare(current, baseline, {}, 0.05);
+    std::stringstream broken("{\"benchmarks\": [{\"name\": 1");
+
+    // Assert
+    TEST_CHECK(restored.size() == baseline.size());
+    bool same = restored.size() == baseline.size();
+    for (size_t i{0}; same && i < baseline.size(); i++)
+    {
+        auto const &x = restored[i];
+        auto const &y = baseline[i];
+        same = x.name == y.name && x.elements == y.elements && x.flops == y.flops && x.iterations == y.iterations &&
+               x.seconds == y.seconds && x.samples == y.samples && x.events.size() == y.events.size();
+        for (size_t e{0}; same && e < y.events.size(); e++)
+        {
+            same = x.events[e].name == y.events[e].name && x.events[e].value == y.events[e].value;
+        }
+    }
+    TEST_CHECK(same);
+    TEST_EXCEPTION(bench::read_json(broken), std::runtime_error);
+
+    TEST_CHECK(bench::tolerance_for("multiply 64", rules, 0.05) == 0.1);
+    TEST_CHECK(bench::tolerance_for("multiply 32", rules, 0.05) == 0.3);
+    TEST_CHECK(bench::tolerance_for("noisy", rules, 0.05) == 0.05);
+    TEST_CHECK(verdicts.size() == 3);
+    TEST_CHECK(verdicts[0].verdict == bench::Verdict::Slower); // 20% +- 1% over a 10% tolerance.
+    TEST_CHECK(verdicts[0].change.lower() > 0.1);
+    TEST_CHECK(verdicts[1].verdict == bench::Verdict::Unchanged); // 30% slower on average, but the interval spans 0.
+    TEST_CHECK(verdicts[1].change.estimate > 0.05 && verdicts[1].change.lower() < 0.05);
+    TEST_CHECK(verdicts[2].verdict == bench::Verdict::NoBaseline);
+    TEST_CHECK(faster[0].verdict == bench::Verdict::Faster);
+}
+
 // Define more test cases as needed...
 
 TEST_LIST = {
@@ -144,5 +1960,50 @@ TEST_LIST = {
     {"test_matrix_iteration_modification", test_matrix_iteration_modification},
     {"test_matrix_iteration_out_of_range_error_row", test_matrix_iteration_out_of_range_error_row},
     {"test_matrix_iteration_out_of_range_error_col", test_matrix_iteration_out_of_range_error_col},
+    {"test_cholesky_factor", test_cholesky_factor},
+    {"test_cholesky_solve", test_cholesky_solve},
+    {"test_cholesky_not_positive_definite", test_cholesky_not_positive_definite},
+    {"test_thread_pool", test_thread_pool},
+    {"test_compact_float_conversion", test_compact_float_conversion},
+    {"test_compact_float_bulk_conversion", test_compact_float_bulk_conversion},
+    {"test_compact_float_operations", test_compact_float_operations},
+    {"test_multiply_wide", test_multiply_wide},
+    {"test_multiply_scaled", test_multiply_scaled},
+    {"test_matrix_resize", test_matrix_resize},
+    {"test_matrix_concatenation", test_matrix_concatenation},
+    {"test_matrix_large_concatenation", test_matrix_large_concatenation},
+    {"test_matrix_block_assembly", test_matrix_block_assembly},
+    {"test_matrix_transpose", test_matrix_transpose},
+    {"test_matrix_transpose_large", test_matrix_transpose_large},
+    {"test_matrix_transpose_inplace", test_matrix_transpose_inplace},
+    {"test_matrix_padded_storage", test_matrix_padded_storage},
+    {"test_matrix_padded_operations", test_matrix_padded_operations},
+    {"test_batched_multiply_add", test_batched_multiply_add},
+    {"test_batched_inverse", test_batched_inverse},
+    {"test_work_deque", test_work_deque},
+    {"test_task_scheduler", test_task_scheduler},
+    {"test_multiply_out_of_core", test_multiply_out_of_core},
+    {"test_instrumentation", test_instrumentation},
+    {"test_zero_allocation_paths", test_zero_allocation_paths},
+    {"test_numa_placement", test_numa_placement},
+    {"test_reductions", test_reductions},
+    {"test_axis_reductions", test_axis_reductions},
+    {"test_compensated_summation", test_compensated_summation},
+    {"test_map_zip_with", test_map_zip_with},
+    {"test_map_inplace", test_map_inplace},
+    {"test_broadcasting", test_broadcasting},
+    {"test_row_col_ranges", test_row_col_ranges},
+    {"test_tiles", test_tiles},
+    {"test_copy_on_write", test_copy_on_write},
+    {"test_gemv", test_gemv},
+    {"test_triangular", test_triangular},
+    {"test_banded", test_banded},
+    {"test_pairwise_distances", test_pairwise_distances},
+    {"test_nearest_neighbors", test_nearest_neighbors},
+    {"test_covariance", test_covariance},
+    {"test_external_view", test_external_view},
+    {"test_adopted_buffer", test_adopted_buffer},
+    {"test_bench_statistics", test_bench_statistics},
+    {"test_bench_baseline", test_bench_baseline},
     // Add more test cases...
-};
+    {NULL, NULL}};